@@ -0,0 +1,889 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// main-loop benchmarks for the host build
+// runs setup() then a set of scripted scenarios against the sketch - encoder turns clocked out as quadrature on the
+// encoder pins, button holds, MIDI on Serial1, the volume pot - with the XVA1 stand-in in xva1sim.h on Serial2
+// for each scenario it reports loop() pass times (median, percentiles, worst case), the cost of the timer ISRs
+// and the UART traffic per edit, plus the time from an edit to the XVA1 applying it and patch load throughput
+// the sketch runs on the HAL's virtual clock: every loop() pass takes PASS_US of it and the script, the XVA1 stand-in and
+// the timer ISRs all go by it, so everything but the pass and ISR times comes out the same on every run. the pass and
+// ISR times are the host CPU time the sketch took - use them to compare builds, not to predict the ESP32
+//
+// usage: xva1bench [-l latency us] [-j jitter us] [-d drops per 10000] [-s seed] [-p tty] [-t] [scenario name ...]
+//   -l -j -d -s set up the XVA1 stand-in, see xva1sim.h. -p talks to an XVA1 on a tty instead - a real one on a USB
+//   serial adapter or xva1sim on a pty. -t sends "trace" to the sketch after each scenario, the dumps go to stderr
+//   with the rest of the debug output for tools/tracedecode.py. no names runs all the scenarios
+
+#include "Arduino.h"
+#include "Preferences.h"
+#include "io.h"
+#include "xva1sim.h"
+#include <algorithm>
+#include <functional>
+#include <unistd.h>
+#include <vector>
+
+// the sketch is compiled in with the bench so its declarations and constants come straight from its headers
+#include "xva1_LCDV3.ino"
+
+#define POT_SWEEP 2048  // ms for the slow pot sweep, 2 A/D counts a ms
+#define QUAD_US 1000  // us between quadrature transitions - the encoder timer samples every 500us
+#define PASS_US 20    // virtual time a loop() pass takes, on top of anything it waits for
+
+// ----------------------------------------------------------------------------
+// scripted input - events at times relative to the start of a scenario
+
+struct event {
+  uint64_t at;  // us
+  std::function<void(void)> fn;
+};
+
+static std::vector<event> script;
+static std::vector<uint64_t> edits;  // when each encoder notch or controller message that edits a parameter went in
+
+static void at(uint64_t us, std::function<void(void)> fn)
+{
+  script.push_back(event{us, fn});
+}
+
+// one notch is four quadrature transitions, pins rest high on the detent. dir 1 counts up
+// the edit happens on the last transition, when the decoder sees the detent
+static void notch(uint64_t us, uint8_t pina, uint8_t pinb, int8_t dir, bool edit)
+{
+  static const uint8_t up[4][2] = {{1, 0}, {0, 0}, {0, 1}, {1, 1}};
+  static const uint8_t down[4][2] = {{0, 1}, {0, 0}, {1, 0}, {1, 1}};
+  for (uint8_t i = 0; i < 4; ++i) {
+    uint8_t a = (dir > 0) ? up[i][0] : down[i][0];
+    uint8_t b = (dir > 0) ? up[i][1] : down[i][1];
+    at(us + i * QUAD_US, [=]() { hal_setpin(pina, a); hal_setpin(pinb, b); });
+  }
+  if (edit) edits.push_back(us + 3 * QUAD_US);
+}
+
+// count notches spread evenly over ms
+static void turn(uint64_t start, uint8_t pina, uint8_t pinb, int16_t count, uint32_t ms, bool edit)
+{
+  uint16_t n = abs(count);
+  for (uint16_t i = 0; i < n; ++i) notch(start + (uint64_t)i * ms * 1000 / n, pina, pinb, (count > 0) ? 1 : -1, edit);
+}
+
+// ----------------------------------------------------------------------------
+// running and measuring
+
+static std::vector<uint32_t> passes;     // host CPU time of each loop() pass in ns
+static std::vector<uint32_t> latencies;  // us from an edit to the XVA1 applying it
+static uint64_t runstart;                // hal_micros() at the start of the measured run
+static size_t nextedit;                  // first edit that hasn't reached the XVA1
+static char results[200];                // scenario specific results for the report
+static bool simulated = true;            // the XVA1 is xva1sim in this process on the virtual clock, not on a tty
+static int16_t watched = -1;             // only frames for this parameter carry edits, -1 for any
+static int16_t learned;                  // parameter of the last frame seen by learnparam()
+static uint32_t potsamplestart;          // potsamples/potevents at the start of the measured run
+static uint32_t poteventstart;
+static bool volumeseen[256];             // volume values the XVA1 was sent
+
+// a frame landed in the XVA1 - it carries every edit made before it that hadn't gone out yet
+// notches the write queue merged into one frame each count from their own time
+static void applied(uint16_t param, uint8_t val, uint64_t at)
+{
+  learned = param;
+  if (param == 509) volumeseen[val] = true;
+  if ((at < runstart) || ((watched >= 0) && (param != watched))) return;
+  for (; (nextedit < edits.size()) && (edits[nextedit] <= at - runstart); ++nextedit) {
+    latencies.push_back(at - runstart - edits[nextedit]);
+  }
+}
+
+// run loop() for ms while playing the script
+// on a tty the clock is the host's and loop() runs flat out, otherwise each pass moves the virtual clock PASS_US
+static void run(uint32_t ms, bool measure)
+{
+  std::sort(script.begin(), script.end(), [](const event & a, const event & b) { return a.at < b.at; });
+  std::sort(edits.begin(), edits.end());
+  uint64_t start = hal_micros();
+  size_t next = 0;
+  if (measure) {
+    runstart = start;
+    nextedit = 0;
+  }
+  sim_onapply = measure ? applied : NULL;
+  while (hal_micros() - start < (uint64_t)ms * 1000) {
+    while ((next < script.size()) && (hal_micros() - start >= script[next].at)) script[next++].fn();
+    uint64_t t0 = hal_hostnanos();
+    loop();
+    if (measure) passes.push_back(hal_hostnanos() - t0);
+    if (simulated) hal_skip(PASS_US);
+  }
+  sim_onapply = NULL;
+  script.clear();
+}
+
+// p of a sorted vector
+static double percentile(const std::vector<uint32_t> & v, double p)
+{
+  if (v.empty()) return 0;
+  return v[(size_t)(p * (v.size() - 1))];
+}
+
+static void isrstats(uint8_t num, double & avg, double & worst, uint32_t & missed)
+{
+  hw_timer_t * t = hal_timer(num);
+  avg = (t && t->calls) ? (double)t->nanos / t->calls / 1000.0 : 0;
+  worst = t ? t->maxnanos / 1000.0 : 0;
+  missed = t ? t->missed : 0;
+}
+
+static void header(void)
+{
+  printf("%-12s %8s %7s %7s %7s %8s %8s  %11s %11s %6s %8s %8s %6s %9s %8s\n", "scenario", "passes", "p50", "p90", "p99",
+         "p99.9", "max", "enc isr", "lcd isr", "missed", "s2 tx", "s2 rx", "edits", "tx/edit", "lcd");
+  printf("%-12s %8s %7s %7s %7s %8s %8s  %11s %11s %6s %8s %8s %6s %9s %8s\n", "", "", "us", "us", "us", "us", "us",
+         "avg/max us", "avg/max us", "", "bytes", "bytes", "", "bytes", "bytes");
+}
+
+static void report(const char * name)
+{
+  std::sort(passes.begin(), passes.end());
+  double encavg, encmax, lcdavg, lcdmax;
+  uint32_t encmissed, lcdmissed;
+  isrstats(1, encavg, encmax, encmissed);
+  isrstats(2, lcdavg, lcdmax, lcdmissed);
+  double potavg, potmax;
+  uint32_t potmissed;
+  isrstats(0, potavg, potmax, potmissed);
+  char enc[24], lcd[24], per[16];
+  snprintf(enc, sizeof(enc), "%.2f/%.1f", encavg, encmax);
+  snprintf(lcd, sizeof(lcd), "%.2f/%.1f", lcdavg, lcdmax);
+  if (edits.size()) snprintf(per, sizeof(per), "%.2f", (double)Serial2.txbytes / edits.size());
+  else snprintf(per, sizeof(per), "-");
+  printf("%-12s %8zu %7.2f %7.2f %7.2f %8.2f %8.2f  %11s %11s %6u %8u %8u %6zu %9s %8u\n", name, passes.size(),
+         percentile(passes, 0.5) / 1000, percentile(passes, 0.9) / 1000, percentile(passes, 0.99) / 1000,
+         percentile(passes, 0.999) / 1000, percentile(passes, 1.0) / 1000, enc, lcd, encmissed + lcdmissed + potmissed,
+         Serial2.txbytes, Serial2.rxbytes, edits.size(), per, hal_lcdbytes());
+  if (latencies.size()) {
+    std::sort(latencies.begin(), latencies.end());
+    printf("%-12s edit to apply: %zu of %zu edits, p50 %.2f ms, p99 %.2f ms, max %.2f ms\n", "", latencies.size(),
+           edits.size(), percentile(latencies, 0.5) / 1000, percentile(latencies, 0.99) / 1000,
+           percentile(latencies, 1.0) / 1000);
+  }
+  if (results[0]) printf("%-12s %s\n", "", results);
+}
+
+// ----------------------------------------------------------------------------
+// scenarios
+
+// start a measured run over after setting things up
+static void restart(void)
+{
+  hal_resetstats();
+  passes.clear();
+  latencies.clear();
+  edits.clear();
+  results[0] = 0;
+  watched = -1;
+  potsamplestart = potsamples;
+  poteventstart = potevents;
+}
+
+// a scenario that can't set itself up would measure the wrong thing and one that checks the sketch got it wrong - stop
+// with an error instead
+static void fail(const char * scenario, const char * why)
+{
+  printf("%s: %s\n", scenario, why);
+  exit(1);
+}
+
+// find the parameter an encoder edits by turning it one notch and back
+static int16_t learnparam(const char * scenario, uint8_t pina, uint8_t pinb)
+{
+  learned = -1;
+  turn(0, pina, pinb, 1, 10, false);
+  turn(50000, pina, pinb, -1, 10, false);
+  run(100, true);
+  int16_t param = learned;
+  restart();
+  if (param < 0) fail(scenario, "the encoder didn't edit anything");
+  return param;
+}
+
+// hold the menu encoder button and scroll the top menus once round until name is on the top line
+// the button is held past the hold time first so letting it go isn't a click - two quick ones would switch menus
+static bool findmenu(const char * name)
+{
+  hal_setpin(ENC_SW, LOW);
+  run(600, false);
+  for (uint8_t i = 0; (i < 128) && strncmp(hal_lcdrow(0), name, strlen(name)); ++i) {
+    turn(0, ENC_A, ENC_B, 1, 10, false);
+    run(100, false);  // slow enough that the encoder doesn't accelerate past it
+  }
+  hal_setpin(ENC_SW, HIGH);
+  run(100, false);
+  return !strncmp(hal_lcdrow(0), name, strlen(name));
+}
+
+// go to the first page of a top menu, in the main or the secondary menu - wherever the last scenario left us
+static void gotomenu(const char * scenario, const char * name)
+{
+  if (!findmenu(name)) {
+    for (uint8_t i = 0; i < 2; ++i) {  // double click switches between the main and secondary menus
+      hal_setpin(ENC_SW, LOW);
+      run(50, false);
+      hal_setpin(ENC_SW, HIGH);
+      run(50, false);
+    }
+    run(1000, false);  // past the double click time
+    if (!findmenu(name)) fail(scenario, "couldn't find the menu");
+  }
+  turn(0, ENC_A, ENC_B, -20, 400, false);  // back to its first parameters
+  run(500, false);
+  edits.clear();
+}
+
+static void idle(void)
+{
+  run(1000, true);
+}
+
+// one parameter encoder at a comfortable speed - the third field is Detune on the first screen
+static void editslow(void)
+{
+  turn(0, P3ENC_A, P3ENC_B, 20, 1000, true);
+  run(1000, true);
+}
+
+// all four parameter encoders spun hard at once
+static void editfast(void)
+{
+  turn(0, P1ENC_A, P1ENC_B, 100, 1000, true);
+  turn(0, P2ENC_A, P2ENC_B, -100, 1000, true);
+  turn(0, P3ENC_A, P3ENC_B, 100, 1000, true);
+  turn(0, P4ENC_A, P4ENC_B, -100, 1000, true);
+  run(1000, true);
+}
+
+// scroll thru the top menus and back - every notch redraws the whole screen
+static void menuscroll(void)
+{
+  hal_setpin(ENC_SW, LOW);
+  turn(50000, ENC_A, ENC_B, 10, 450, false);
+  turn(500000, ENC_A, ENC_B, -10, 450, false);
+  at(980000, []() { hal_setpin(ENC_SW, HIGH); });
+  run(1000, true);
+}
+
+// the volume the pot gives when it is turned up to reading - the dead band in potscan.h leaves the tracked reading
+// POT_HYSTERESIS counts behind
+static unsigned potvolume(uint16_t reading)
+{
+  return pot_scale(pot_scaletracked(reading - POT_HYSTERESIS), 255);
+}
+
+// scroll thru memory slots in the Load Patch menu, then sit on one while it loads and prefetches
+// the volume pot is turned after the load - the synth should end up on the selected patch with the pot's volume even
+// though the prefetches had it on other patches since
+static void browse(void)
+{
+  gotomenu("browse", "Load Patch");
+  restart();
+  uint32_t hits = cachehits, prefetches = cacheprefetches;
+  turn(0, P1ENC_A, P1ENC_B, 20, 1000, false);
+  turn(2500000, P1ENC_A, P1ENC_B, 1, 10, false);  // onto a prefetched neighbour
+  at(2600000, []() { hal_setanalog(VOLUMEPOT, 2900); });
+  run(4000, true);
+  if (simulated) {
+    uint16_t differ = 0;
+    for (uint16_t i = 1; i < SIM_PARAMS; ++i) {
+      if (simimage[i] != parameters[i]) ++differ;
+    }
+    snprintf(results, sizeof(results), "%u cache hits, %u prefetches, synth volume %u after them, pot 2900 is %u, %u parameters differ from the editor",
+             cachehits - hits, cacheprefetches - prefetches, simimage[509], potvolume(2900), differ);
+    if (differ || (simimage[509] != potvolume(2900))) {
+      report("browse");
+      fail("browse", "the synth isn't on the selected patch with the pot's volume");
+    }
+  }
+  hal_setanalog(VOLUMEPOT, 2000);
+}
+
+// a DAW sweeping the on screen parameters with CC 20-23 as fast as MIDI can carry them
+static void midicc(void)
+{
+  gotomenu("midi-cc", "Oscillator 1");
+  restart();
+  for (uint16_t i = 0; i < 1000; ++i) {
+    uint8_t msg[3] = {0xB0, (uint8_t)(20 + (i & 3)), (uint8_t)((i / 4) & 0x7f)};
+    at((uint64_t)i * 1000, [=]() { Serial1.hal_inject(msg, 3); });
+    edits.push_back((uint64_t)i * 1000);
+  }
+  run(1000, true);
+}
+
+// a DAW sending NRPNs while loop() was busy - 40 of them, 241 bytes waiting on Serial1 at once, 120 CC events
+// every one has to land, the parser's queue only holds 32 events. then 64 while a patch save waits 30ms for the synth's
+// ack, so the link queue fills behind it and the write queue after that - writes wait outside the queue and the synth
+// has to end up with every last value anyway. all of them have range 255
+static const uint16_t nrpnparams[] = {15, 16, 17, 18, 19, 20, 21, 73, 74, 75, 76, 77, 79, 165, 174, 175, 180, 181, 184, 185,
+                                      188, 189, 192, 193, 200, 203, 204, 205, 208, 209, 212, 213, 246, 276, 277, 285, 286, 287,
+                                      288, 305, 306, 308, 320, 321, 351, 352, 395, 396, 431, 433, 434, 435, 436, 437, 438, 439,
+                                      440, 441, 442, 443, 444, 445, 446, 447};
+
+static std::vector<uint8_t> nrpnmsg(uint16_t count, uint8_t seed)
+{
+  std::vector<uint8_t> msg(1, 0xB0);  // running status for the rest
+  for (uint16_t i = 0; i < count; ++i) {
+    uint8_t nrpn[6] = {99, (uint8_t)(nrpnparams[i] >> 7), 98, (uint8_t)(nrpnparams[i] & 0x7f), 6, (uint8_t)((i * 37 + seed) & 0x7f)};
+    msg.insert(msg.end(), nrpn, nrpn + 6);
+  }
+  return msg;
+}
+
+// parameters that don't have the value nrpnmsg() sent, in the editor and on the synth
+static uint16_t nrpnwrong(uint16_t count, uint8_t seed, uint16_t & synthwrong)
+{
+  uint16_t wrong = 0;
+  synthwrong = 0;
+  for (uint16_t i = 0; i < count; ++i) {
+    uint8_t val = ((i * 37 + seed) & 0x7f) << 1;
+    if (parameters[nrpnparams[i]] != val) ++wrong;
+    if (simulated && (simimage[nrpnparams[i]] != val)) ++synthwrong;
+  }
+  return wrong;
+}
+
+static void nrpnburst(void)
+{
+  std::vector<uint8_t> msg = nrpnmsg(40, 11);
+  uint16_t overflows = midioverflows;
+  at(0, [=]() { Serial1.hal_inject(msg.data(), msg.size()); });
+  edits.assign(40, 0);
+  run(300, true);
+  uint16_t synthwrong;
+  uint16_t wrong = nrpnwrong(40, 11, synthwrong);
+  snprintf(results, sizeof(results), "40 NRPNs in %u bytes, %u MIDI events lost, %u/%u wrong in the editor/synth",
+           (unsigned)msg.size(), midioverflows - overflows, wrong, synthwrong);
+  if (simulated) {
+    const uint16_t count = sizeof(nrpnparams) / sizeof(nrpnparams[0]);
+    std::vector<uint8_t> msg2 = nrpnmsg(count, 90);
+    uint32_t deferred = writeqdeferred;
+    struct simconfig saved = sim;
+    sim.latency = 30000;
+    at(0, []() { writepatch(120, NULL); });
+    at(2000, [=]() { Serial1.hal_inject(msg2.data(), msg2.size()); });
+    run(300, false);
+    sim = saved;
+    uint16_t synthwrong2;
+    uint16_t wrong2 = nrpnwrong(count, 90, synthwrong2);
+    size_t len = strlen(results);
+    snprintf(results + len, sizeof(results) - len, ", %u during a save %u/%u wrong with %u writes deferred", count, wrong2,
+             synthwrong2, (unsigned)(writeqdeferred - deferred));
+    synthwrong += synthwrong2;
+    wrong += wrong2;
+  }
+  if (wrong || synthwrong || (midioverflows != overflows)) {
+    report("nrpn-burst");
+    fail("nrpn-burst", "remote edits were lost");
+  }
+}
+
+// cost of the pot sampling interrupt and what it read
+static void potresults(void)
+{
+  double avg, worst;
+  uint32_t missed;
+  isrstats(0, avg, worst, missed);
+  snprintf(results, sizeof(results), "pot isr avg/max %.2f/%.1f us, %u samples, %u pot events", avg, worst,
+           (unsigned)(potsamples - potsamplestart), potevents - poteventstart);
+}
+
+// volume pot turned end to end
+static void volumeturn(void)
+{
+  for (uint16_t i = 0; i < 1000; ++i) {
+    at((uint64_t)i * 1000, [=]() { hal_setanalog(VOLUMEPOT, i * 4); });
+    edits.push_back((uint64_t)i * 1000);
+  }
+  run(1200, true);
+  potresults();
+}
+
+// volume pot left alone with +-40 counts of A/D noise, about what the ESP32 A/D does - nothing should go to the synth
+static void potnoise(void)
+{
+  hal_setanalog(VOLUMEPOT, 2000, 40);
+  run(200, false);   // let the first reading go out
+  restart();
+  run(1000, true);
+  potresults();
+  hal_setanalog(VOLUMEPOT, 2000);
+  if (potevents != poteventstart) {
+    report("pot-noise");
+    fail("pot-noise", "A/D noise moved the pot");
+  }
+}
+
+// volume pot turned slowly end to end and back with a little noise - every volume should be reached both ways
+static void potsweep(void)
+{
+  uint16_t seen[2] = {0, 0};
+  hal_setanalog(VOLUMEPOT, 0, 8);
+  run(100, false);
+  for (uint8_t down = 0; down < 2; ++down) {
+    memset(volumeseen, 0, sizeof(volumeseen));
+    for (uint16_t i = 0; i <= POT_SWEEP; ++i) {
+      uint16_t v = down ? (POT_SWEEP - i) * 2 : i * 2;
+      at((uint64_t)i * 1000, [=]() { hal_setanalog(VOLUMEPOT, v, 8); });
+    }
+    run(POT_SWEEP + 100, true);
+    for (uint16_t v = 0; v < 256; ++v) seen[down] += volumeseen[v];
+  }
+  potresults();
+  size_t len = strlen(results);
+  snprintf(results + len, sizeof(results) - len, ", %u of 256 volumes going up, %u going down", seen[0], seen[1]);
+  hal_setanalog(VOLUMEPOT, 2000);
+  if ((seen[0] != 256) || (seen[1] != 256)) {
+    report("pot-sweep");
+    fail("pot-sweep", "the sweep missed volumes");
+  }
+}
+
+// patch loads queued back to back with an empty patch cache - every one is an 'r' and a 512 byte dump
+
+#define LOADS 16
+
+static uint8_t loadsdone;
+static uint8_t loadsfailed;
+static uint64_t loadstart;
+static uint64_t loadend;
+
+static void loaddone(uint8_t, uint8_t result)
+{
+  ++loadsdone;
+  if (result != 0) ++loadsfailed;  // SYNTH_OK is 0
+  loadend = hal_micros();
+}
+
+static void loads(uint8_t count, uint32_t ms)
+{
+  uint16_t timeouts = synthtimeouts;
+  loadsdone = loadsfailed = 0;
+  cache_init();
+  at(0, [=]() {
+    loadstart = hal_micros();
+    for (uint8_t i = 0; i < count; ++i) loadpatch(i, loaddone);
+  });
+  run(ms, true);
+  double t = (loadsdone ? (loadend - loadstart) : 0) / 1000.0;
+  snprintf(results, sizeof(results), "%u of %u loads in %.1f ms, %.1f kbytes/s of dumps, %u timeouts, %u failed", loadsdone,
+           count, t, (t > 0) ? (loadsdone - loadsfailed) * 512.0 / t : 0.0, (uint16_t)(synthtimeouts - timeouts), loadsfailed);
+}
+
+static void bulkload(void)
+{
+  loads(LOADS, 1000);
+}
+
+// a slow XVA1 that loses the odd byte - dumps with a missing byte time out and are asked for again
+static void lossyload(void)
+{
+  struct simconfig saved = sim;
+  sim.latency = 2000;
+  sim.jitter = 3000;
+  sim.droprate = 5;
+  loads(LOADS, 5000);
+  sim = saved;
+}
+
+// a powered off XVA1 - the loads have to give up without holding up the UI
+static void deadsynth(void)
+{
+  struct simconfig saved = sim;
+  sim.dead = true;
+  loads(4, 2000);
+  sim = saved;
+}
+
+// the timeout and retry paths of the link against a fixed drop pattern - has to come out exactly like this every run
+// slot 0: its ack is lost and the 'r' is resent, then a dump byte is lost and the 'd' is resent
+// slot 1: three acks in a row are lost and the load gives up. slot 2 loads first time
+static bool retryright;  // the last load brought in slot 2's image
+
+static void retryloaded(uint8_t cmd, uint8_t result)
+{
+  loaddone(cmd, result);
+  if (loadsdone == 3) retryright = (result == 0) && !memcmp(parameters, simslots[2], SIM_PARAMS);
+}
+
+static void retry(void)
+{
+  static const uint32_t drops[] = {1, 100, 1027, 1028, 1029};
+  for (uint16_t i = 0; (i < 1000) && synth_busy(); ++i) run(1, false);  // a background dump would shift the numbering
+  struct simconfig saved = sim;
+  sim.droplist = drops;
+  sim.dropcount = sizeof(drops) / sizeof(drops[0]);
+  sim_resetstats();
+  uint16_t timeouts = synthtimeouts;
+  loadsdone = loadsfailed = 0;
+  cache_init();
+  retryright = false;
+  for (uint8_t i = 0; i < 3; ++i) loadpatch(i, retryloaded);
+  run(2000, true);
+  sim = saved;
+  timeouts = synthtimeouts - timeouts;
+  snprintf(results, sizeof(results), "%u of 3 loads, %u failed, %u timeouts, %u of 5 bytes dropped, last load %s", loadsdone,
+           loadsfailed, timeouts, simstat.dropped, retryright ? "right" : "wrong");
+  if ((loadsdone != 3) || (loadsfailed != 1) || (timeouts != 5) || (simstat.dropped != 5) || !retryright) {
+    report("retry");
+    fail("retry", "the link didn't retry and give up as it should");
+  }
+}
+
+// edits while the link streams a whole patch to the synth - what snapshot and library loads do
+static void uploadedit(void)
+{
+  watched = learnparam("upload-edit", P3ENC_A, P3ENC_B);  // upload frames don't count as edits arriving
+  snapshotsave();
+  at(0, []() { snapshotload(); });  // 512 parameter frames
+  turn(20000, P3ENC_A, P3ENC_B, 20, 200, true);
+  run(600, true);
+}
+
+// the third field changed on the XVA1 itself, as its MIDI input or another editor would, five times 1.1s apart
+// measures how long the editor takes to show each change and checks they aren't shown as edits. the waveform is set past
+// the end of its menu range on the synth too - the editor should keep the synth's value, not quietly limit it
+static void externaledit(void)
+{
+  int16_t param = learnparam("external-edit", P3ENC_A, P3ENC_B);
+  at(0, []() { loadpatch(5, patchloaded); });  // no edits - learnparam() made one
+  run(300, false);
+  restart();
+  static uint64_t changed[5], seen[5];
+  for (uint8_t i = 0; i < 5; ++i) {
+    changed[i] = seen[i] = 0;
+    at((uint64_t)i * 1100000, [=]() { simimage[param] = 10 + i; changed[i] = hal_micros(); });
+  }
+  at(0, []() { simimage[11] = 20; });
+  for (uint32_t t = 0; t < 6000; ++t) {
+    at((uint64_t)t * 1000, [=]() {
+      for (uint8_t i = 0; i < 5; ++i) {
+        if (changed[i] && !seen[i] && (parameters[param] == 10 + i)) seen[i] = hal_micros();
+      }
+    });
+  }
+  run(6000, true);
+  uint8_t n = 0;
+  double total = 0, worst = 0;
+  for (uint8_t i = 0; i < 5; ++i) {
+    if (!seen[i]) continue;
+    double ms = (seen[i] - changed[i]) / 1000.0;
+    total += ms;
+    if (ms > worst) worst = ms;
+    ++n;
+  }
+  snprintf(results, sizeof(results), "%u of 5 changes on the synth shown, avg %.1f ms, max %.1f ms, %s, waveform 20 on the synth is %u",
+           n, n ? total / n : 0, worst, strchr(hal_lcdrow(3), '*') ? "marked as edits" : "not marked as edits", parameters[11]);
+  if ((n != 5) || strchr(hal_lcdrow(3), '*') || (parameters[11] != 20)) {
+    report("external-edit");
+    fail("external-edit", "changes on the synth weren't shown as they are");
+  }
+}
+
+// a patch loaded from a slot and edited, then the XVA1 is power cycled and comes back with its init patch
+// the editor should notice on its next background dump and put the patch back with a recall and the edited parameters
+static void synthreset(void)
+{
+  at(0, []() { loadpatch(5, patchloaded); });
+  run(300, false);
+  turn(0, P3ENC_A, P3ENC_B, 5, 100, false);
+  turn(0, P4ENC_A, P4ENC_B, -3, 100, false);
+  run(1500, false);
+  static uint8_t before[SIM_PARAMS];
+  memcpy(before, simimage, SIM_PARAMS);
+  sim.dead = true;
+  run(2000, false);   // at least one background dump fails
+  memcpy(simimage, siminit, SIM_PARAMS);
+  sim.dead = false;
+  sim_resetstats();
+  restart();
+  uint16_t restores = syncrestores;
+  run(4000, true);
+  uint16_t differ = 0;
+  for (uint16_t i = 1; i < SIM_PARAMS; ++i) {
+    if (simimage[i] != before[i]) ++differ;
+  }
+  snprintf(results, sizeof(results), "%u restores, %u recalls, %u parameter frames, %u parameters differ from before the reset",
+           syncrestores - restores, simstat.reads, simstat.frames, differ);
+  if ((syncrestores == restores) || differ) {
+    report("synth-reset");
+    fail("synth-reset", "the patch wasn't put back on the synth");
+  }
+}
+
+// a host asks for three slots that aren't in the patch cache while a parameter is being edited and the volume pot turned
+// each slot is read thru the synth's edit buffer - after the export the synth should have the edits and the pot's volume
+static void sysexexport(void)
+{
+  at(0, []() { loadpatch(5, patchloaded); });
+  run(300, false);
+  int16_t param = learnparam("sysex-export", P3ENC_A, P3ENC_B);
+  uint16_t patches = sysexpatches;
+  for (uint8_t i = 0; i < 3; ++i) {
+    at((uint64_t)i * 400000, [=]() {
+      uint8_t msg[] = {0xF0, 0x7D, 0x58, 0x10, (uint8_t)(60 + i), 0xF7};
+      Serial1.hal_inject(msg, sizeof(msg));
+    });
+  }
+  turn(5000, P3ENC_A, P3ENC_B, 10, 1000, false);
+  at(500000, []() { hal_setanalog(VOLUMEPOT, 2900); });
+  run(2000, true);
+  snprintf(results, sizeof(results), "%u patches sent, edited parameter %u on the synth %u, editor %u, synth volume %u for %u",
+           sysexpatches - patches, param, simimage[param], parameters[param], simimage[509], potvolume(2900));
+  hal_setanalog(VOLUMEPOT, 2000);
+  if ((sysexpatches - patches != 3) || (simimage[param] != parameters[param]) || (simimage[509] != potvolume(2900))) {
+    report("sysex-export");
+    fail("sysex-export", "the export lost the edits or the pot's volume");
+  }
+}
+
+// SysEx messages the sketch sends on the MIDI port
+static std::vector<uint8_t> midiout;
+
+static void midisent(uint8_t c, void *)
+{
+  midiout.push_back(c);
+}
+
+// put the 8 chunks of a patch sent as message type, slot in image. false if any are missing or damaged
+static bool sxcollect(uint8_t type, uint8_t slot, uint8_t * image)
+{
+  uint8_t seen = 0;
+  for (size_t i = 0; i + 82 <= midiout.size(); ++i) {
+    const uint8_t * m = &midiout[i];
+    if ((m[0] != 0xF0) || (m[1] != 0x7D) || (m[2] != 0x58) || (m[3] != type) || (m[4] != slot) || (m[5] > 7) || (m[81] != 0xF7)) continue;
+    uint8_t sum = 0;
+    for (uint8_t j = 0; j < 74; ++j) sum += m[6 + j];
+    if ((sum & 0x7F) != m[80]) return false;
+    sysex_unpack(&m[6], 74, image + m[5] * 64);
+    seen |= 1 << m[5];
+  }
+  return seen == 0xFF;
+}
+
+// the last thing sent was this reply
+static bool sxreplied(uint8_t type, uint8_t slot, uint8_t chunk)
+{
+  const uint8_t reply[] = {0xF0, 0x7D, 0x58, type, slot, chunk, 0xF7};
+  return (midiout.size() >= 7) && !memcmp(&midiout[midiout.size() - 7], reply, 7);
+}
+
+// a host backs up slot 127 and the patch being edited, then restores slot 127 with a few bytes changed
+// slot 127 used to share its number with the patch being edited - each has to come out and go back as itself
+static void sysexroundtrip(void)
+{
+  static uint8_t image[SIM_PARAMS], restore[SIM_PARAMS];
+  at(0, []() { loadpatch(5, patchloaded); });
+  run(2500, false);  // the volume pot and a background sync settle - the edit buffer mustn't change while it goes out
+  Serial1.ontx = midisent;
+  midiout.clear();
+  const uint8_t reqslot[] = {0xF0, 0x7D, 0x58, 0x10, 127, 0xF7};
+  Serial1.hal_inject(reqslot, sizeof(reqslot));
+  run(1000, true);
+  bool slotout = sxcollect(0x01, 127, image) && !memcmp(image, simslots[127], SIM_PARAMS);
+
+  midiout.clear();
+  const uint8_t reqedit[] = {0xF0, 0x7D, 0x58, 0x12, 0xF7};
+  Serial1.hal_inject(reqedit, sizeof(reqedit));
+  run(500, true);
+  bool editout = sxcollect(0x04, 0, image) && !memcmp(image, parameters, SIM_PARAMS);
+
+  for (uint16_t i = 0; i < SIM_PARAMS; ++i) restore[i] = simslots[127][i] ^ ((i % 5) ? 0 : 0x81);
+  uint32_t writes = simstat.writes;
+  bool acked = true;
+  for (uint8_t c = 0; c < 8; ++c) {
+    uint8_t msg[82] = {0xF0, 0x7D, 0x58, 0x01, 127, c};
+    uint8_t sum = 0;
+    sysex_pack(restore + c * 64, 64, &msg[6]);
+    for (uint8_t j = 0; j < 74; ++j) sum += msg[6 + j];
+    msg[80] = sum & 0x7F;
+    msg[81] = 0xF7;
+    midiout.clear();
+    Serial1.hal_inject(msg, sizeof(msg));
+    run((c < 7) ? 50 : 1500, true);  // the last one is answered once the synth has written it
+    acked &= sxreplied(0x02, 127, c);
+  }
+  // parameters 255 and 256 are left out - the editor sends 255 unescaped like the XVA1's own UI code, the stand-in
+  // takes it as the escape like the documentation. see synth_sendset()
+  bool slotin = acked && (simstat.writes == writes + 1) && !memcmp(simslots[127], restore, 255)
+                && !memcmp(simslots[127] + 257, restore + 257, SIM_PARAMS - 257);
+  Serial1.ontx = NULL;
+  snprintf(results, sizeof(results), "slot 127 sent %s, edit buffer sent %s, slot 127 restored %s", slotout ? "right" : "wrong",
+           editout ? "right" : "wrong", slotin ? "right" : "wrong");
+  if (!slotout || !editout || !slotin) {
+    report("sysex-127");
+    fail("sysex-127", "SysEx round trip of slot 127 and the edit buffer failed");
+  }
+}
+
+// patch codec round trips on images made to be hard to code - random bytes, bytes alternating with the base, short runs
+// and mixes of them against random bases. every image has to decode back and code to no more than CODEC_MAXLEN
+static void codec(void)
+{
+  static uint8_t image[SYNTH_PARAMS], base[SYNTH_PARAMS], check[SYNTH_PARAMS];
+  static uint8_t code[2 * SYNTH_PARAMS];  // room for a code that breaks the bound
+  uint32_t seed = 1, images = 0, failed = 0, over = 0;
+  uint16_t longest = 0;
+  auto rnd = [&seed]() { seed = seed * 1103515245 + 12345; return (uint8_t)(seed >> 16); };
+  for (uint16_t n = 0; n < 4000; ++n) {
+    uint8_t kind = n % 8;
+    for (uint16_t i = 0; i < SYNTH_PARAMS; ++i) {
+      base[i] = (n & 8) ? rnd() : 0;
+      uint8_t other = base[i] ^ (1 + rnd() % 255);
+      switch (kind) {
+        case 0: image[i] = rnd(); break;                                   // nothing in common
+        case 1: image[i] = (i & 1) ? other : base[i]; break;               // every other byte the same
+        case 2: image[i] = (i % 3) ? other : base[i]; break;               // one in three the same
+        case 3: image[i] = ((i >> 1) & 1) ? 0x55 : 0xAA; break;            // runs of 2
+        case 4: image[i] = (i % 4 == 3) ? base[i] : (uint8_t)(i / 4); break;  // runs of 3 split by a base byte
+        case 5: image[i] = (rnd() & 1) ? base[i] : (rnd() & 1); break;     // random mix, small values
+        case 6: image[i] = (rnd() % 4) ? other : base[i]; break;          // mostly different
+        default: image[i] = (rnd() % 8) ? base[i] : other; break;          // mostly the same
+      }
+    }
+    memset(check, 0, sizeof(check));
+    uint16_t len = codec_encode(image, base, code);
+    if (!codec_decode(code, len, base, check) || memcmp(check, image, SYNTH_PARAMS)) ++failed;
+    if (len > CODEC_MAXLEN) ++over;
+    if (len > longest) longest = len;
+    ++images;
+  }
+  snprintf(results, sizeof(results), "%u images, longest code %u bytes of %u, %u over, %u round trips failed", images, longest,
+           CODEC_MAXLEN, over, failed);
+  if (over || failed) {
+    report("codec");
+    fail("codec", "codes didn't decode back or broke CODEC_MAXLEN");
+  }
+}
+
+// Print to stdout for the sketch's reports
+class stdoutprint : public Print
+{
+public:
+  size_t write(uint8_t c) { return fputc(c, stdout) == EOF ? 0 : 1; }
+  using Print::write;
+};
+
+struct scenario {
+  const char * name;
+  void (*fn)(void);
+  bool simonly;  // needs xva1sim's fault injection, skipped with -p
+};
+
+static const scenario scenarios[] = {
+  {"idle", idle, false},
+  {"edit-slow", editslow, false},
+  {"edit-fast", editfast, false},
+  {"menu-scroll", menuscroll, false},
+  {"browse", browse, false},
+  {"midi-cc", midicc, false},
+  {"nrpn-burst", nrpnburst, false},
+  {"volume-pot", volumeturn, false},
+  {"pot-noise", potnoise, false},
+  {"pot-sweep", potsweep, false},
+  {"bulk-load", bulkload, false},
+  {"upload-edit", uploadedit, false},
+  {"external-edit", externaledit, true},
+  {"lossy-load", lossyload, true},
+  {"dead-synth", deadsynth, true},
+  {"retry", retry, true},
+  {"synth-reset", synthreset, true},
+  {"sysex-export", sysexexport, true},
+  {"sysex-127", sysexroundtrip, true},
+  {"codec", codec, false},
+};
+
+int main(int argc, char ** argv)
+{
+  const char * tty = NULL;
+  bool trace = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "l:j:d:s:p:t")) != -1) {
+    switch (opt) {
+      case 'l': sim.latency = strtoul(optarg, NULL, 0); break;
+      case 'j': sim.jitter = strtoul(optarg, NULL, 0); break;
+      case 'd': sim.droprate = strtoul(optarg, NULL, 0); break;
+      case 's': sim.seed = strtoul(optarg, NULL, 0); break;
+      case 'p': tty = optarg; break;
+      case 't': trace = true; break;
+      default:
+        fprintf(stderr, "usage: %s [-l latency us] [-j jitter us] [-d drops per 10000] [-s seed] [-p tty] [-t] [scenario ...]\n",
+                argv[0]);
+        return 1;
+    }
+  }
+  if (tty) {
+    if (!Serial2.hal_open(tty)) {
+      perror(tty);
+      return 1;
+    }
+    simulated = false;
+    hal_realtime();
+  }
+  else sim_attach(Serial2);
+
+  hal_nvsclear();  // first boot
+  setup();
+  run(2000, false);  // let the boot resync finish
+  printf("setup done at %lu ms, screen:\n", millis());
+  for (uint8_t r = 0; r < 4; ++r) printf("  |%s|\n", hal_lcdrow(r));
+  printf("\n");
+  sim_resetstats();
+
+  header();
+  for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); ++i) {
+    bool wanted = (optind >= argc);
+    for (int a = optind; a < argc; ++a) wanted |= !strcmp(argv[a], scenarios[i].name);
+    if (!wanted || (scenarios[i].simonly && !simulated)) continue;
+    run(300, false);  // let the last scenario finish
+    restart();
+    scenarios[i].fn();
+    report(scenarios[i].name);
+    if (trace) {
+      Serial.hal_inject((const uint8_t *)"trace\n", 6);
+      run(10, false);
+    }
+  }
+  printf("\nlink scheduler:\n");
+  stdoutprint out;
+  sched_report(out);
+  if (simulated) {
+    printf("XVA1 totals: %u frames, %u dumps, %u reads, %u writes, %u inits, %u junk bytes, %u bytes sent, %u dropped\n",
+           simstat.frames, simstat.dumps, simstat.reads, simstat.writes, simstat.inits, simstat.junk, simstat.sent,
+           simstat.dropped);
+  }
+  printf("screen:\n");
+  for (uint8_t r = 0; r < 4; ++r) printf("  |%s|\n", hal_lcdrow(r));
+  return 0;
+}
@@ -0,0 +1,211 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// Arduino/ESP32 stand-in for building the editor on a Linux host - see the README
+// only what the sketch and ClickEncoder use is here. time is a virtual clock that only moves when the host calls
+// hal_skip() and when the sketch waits - delay(), delayMicroseconds() and yield() move it ahead by the time waited - so a
+// run gives the same results on any host under any load. hardware timer interrupts run as the clock passes their alarms
+// and from inside millis(), micros(), the pin and serial calls whenever they are due, the way they would have cut into
+// loop() on the ESP32. hal_realtime() puts the clock on the host's time instead, for talking to a real tty
+// hal_xxx() functions are the host side controls the benchmark uses to drive the pins, serial ports and pots
+
+#ifndef ARDUINO_H_
+#define ARDUINO_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <algorithm>
+#include <deque>
+
+using std::min;
+using std::max;
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define OUTPUT 0x02
+#define PULLUP 0x04
+#define INPUT_PULLUP 0x05
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+#define SERIAL_8N1 0x800001c
+
+#define ICACHE_RAM_ATTR
+#define IRAM_ATTR
+#define PROGMEM
+#define pgm_read_byte(a) (*(const uint8_t *)(a))
+
+#define HAL_PINS 64
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield(void);
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t val);
+uint16_t analogRead(uint8_t pin);
+bool adcAttachPin(uint8_t pin);
+bool adcStart(uint8_t pin);
+bool adcBusy(uint8_t pin);
+uint16_t adcEnd(uint8_t pin);
+int digitalPinToInterrupt(uint8_t pin);
+void attachInterruptArg(uint8_t pin, void (*isr)(void *), void * arg, int mode);
+void detachInterrupt(uint8_t pin);
+
+class Print
+{
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t * buf, size_t n)
+  {
+    for (size_t i = 0; i < n; ++i) write(buf[i]);
+    return n;
+  }
+  size_t write(const char * s) { return write((const uint8_t *)s, strlen(s)); }
+  size_t print(const char * s) { return write(s); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v) { return printf("%d", v); }
+  size_t print(unsigned int v) { return printf("%u", v); }
+  size_t print(long v) { return printf("%ld", v); }
+  size_t print(unsigned long v) { return printf("%lu", v); }
+  size_t println(void) { return print("\r\n"); }
+  template <class T> size_t println(T v) { size_t n = print(v); return n + println(); }
+  size_t printf(const char * format, ...) __attribute__((format(printf, 2, 3)))
+  {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (n < 0) return 0;
+    return write((const uint8_t *)buf, std::min((size_t)n, sizeof(buf) - 1));
+  }
+};
+
+class Stream : public Print
+{
+public:
+  virtual int available(void) = 0;
+  virtual int read(void) = 0;
+  virtual int peek(void) = 0;
+};
+
+// a UART. bytes written go out at the baud rate: availableForWrite() is the room left in the 128 byte TX FIFO and
+// write() waits for room like the ESP32 driver does. the host sees every byte as it is written thru the ontx hook,
+// hal_txtime() says when it will be off the wire. hal_inject() puts bytes in front of the sketch, at a given time if
+// they are still on their way. hal_open() connects the port to a tty instead - a pty or a USB serial adapter
+class HardwareSerial : public Stream
+{
+public:
+  HardwareSerial(uint8_t uart);
+  void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxpin = -1, int8_t txpin = -1);
+  void end(void) {}
+  int available(void);
+  int read(void);
+  int peek(void);
+  int availableForWrite(void);
+  void flush(void);
+  size_t write(uint8_t c);
+  using Print::write;
+
+  // host side
+  void hal_inject(uint8_t c, uint64_t at = 0);
+  void hal_inject(const uint8_t * buf, size_t n, uint64_t at = 0);
+  uint64_t hal_txtime(void) { return txtime; }
+  bool hal_open(const char * path);
+  void (*ontx)(uint8_t c, void * arg);  // called for every byte the sketch writes
+  void * txarg;
+  uint32_t txbytes;      // bytes written by the sketch
+  uint32_t rxbytes;      // bytes read by the sketch
+  uint32_t txwaits;      // writes that had to wait for room in the FIFO
+
+private:
+  struct rxbyte {
+    uint64_t at;         // hal_micros() when it is in the RX FIFO
+    uint8_t c;
+  };
+  void drain(void);
+  void receive(void);
+  uint8_t uart;
+  int fd;                  // tty, -1 if none
+  unsigned long baud;
+  uint16_t fifo;           // bytes in the TX FIFO
+  uint64_t drained;        // hal_micros() up to which the FIFO has been emptied
+  uint64_t txtime;         // hal_micros() when the last byte written is off the wire
+  std::deque<rxbyte> rx;   // in order of arrival
+};
+
+extern HardwareSerial Serial, Serial1, Serial2;
+
+// hardware timers - the divider is applied to the 80MHz APB clock like on the ESP32
+typedef struct hw_timer_s {
+  uint8_t num;
+  uint16_t divider;
+  void (*isr)(void);
+  uint64_t alarm;      // in timer ticks
+  bool autoreload;
+  bool enabled;
+  uint64_t next;       // hal_micros() of the next alarm
+  // statistics
+  uint32_t calls;
+  uint32_t missed;     // alarms that came due again before the last one was serviced
+  uint64_t nanos;      // total host time spent in the ISR
+  uint32_t maxnanos;
+} hw_timer_t;
+
+hw_timer_t * timerBegin(uint8_t num, uint16_t divider, bool countUp);
+void timerAttachInterrupt(hw_timer_t * timer, void (*isr)(void), bool edge);
+void timerAlarmWrite(hw_timer_t * timer, uint64_t alarm, bool autoreload);
+void timerAlarmEnable(hw_timer_t * timer);
+void timerAlarmDisable(hw_timer_t * timer);
+
+// host side controls
+uint64_t hal_micros(void);                     // the clock in us, not truncated
+void hal_skip(uint32_t us);                    // move the clock ahead, running the timer interrupts on the way
+void hal_realtime(void);                       // follow the host's clock from here on - call before setup()
+uint64_t hal_hostnanos(void);                  // host time in ns, to measure what the sketch costs
+uint32_t hal_cyclemhz(void);                   // rate of the cycle counter trace.h uses on the host
+void hal_poll(void);                           // run any timer interrupts that are due
+void hal_setpin(uint8_t pin, uint8_t level);   // drive an input pin, runs its pin change interrupt
+void hal_setanalog(uint8_t pin, uint16_t val, uint16_t noise = 0); // A/D reading of a pin, +-noise counts of random noise
+hw_timer_t * hal_timer(uint8_t num);           // NULL if the sketch hasn't started it
+void hal_resetstats(void);                     // zero the timer and serial counters
+const char * hal_lcdrow(uint8_t row);          // text on the HD44780 decoded from its pins
+uint32_t hal_lcdbytes(void);                   // bytes clocked into the HD44780
+
+#endif // ARDUINO_H_
@@ -0,0 +1,59 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// LiquidCrystal stand-in for the host build
+// the sketch only uses it to initialize the display, LCDAsync does all the output by toggling the pins
+// the constructor tells the HAL which pins the HD44780 is on so it can decode what LCDAsync clocks out
+
+#ifndef LIQUIDCRYSTAL_H_
+#define LIQUIDCRYSTAL_H_
+
+#include "Arduino.h"
+
+void hal_lcdattach(uint8_t rs, uint8_t enable, uint8_t d4, uint8_t d5, uint8_t d6, uint8_t d7);
+void hal_lcdcommand(uint8_t cmd);
+void hal_lcdwrite(uint8_t c);
+
+class LiquidCrystal : public Print
+{
+public:
+  LiquidCrystal(uint8_t rs, uint8_t enable, uint8_t d4, uint8_t d5, uint8_t d6, uint8_t d7)
+  {
+    hal_lcdattach(rs, enable, d4, d5, d6, d7);
+  }
+  void begin(uint8_t, uint8_t) { clear(); }
+  void clear(void) { hal_lcdcommand(0x01); }
+  void home(void) { hal_lcdcommand(0x02); }
+  void setCursor(uint8_t col, uint8_t row)
+  {
+    static const uint8_t rowoffsets[] = {0x00, 0x40, 0x14, 0x54};
+    hal_lcdcommand(0x80 | (col + rowoffsets[row & 3]));
+  }
+  size_t write(uint8_t c) { hal_lcdwrite(c); return 1; }
+  using Print::write;
+};
+
+#endif // LIQUIDCRYSTAL_H_
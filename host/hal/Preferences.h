@@ -0,0 +1,75 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// ESP32 Preferences (NVS) stand-in for the host build - keys live in memory for the life of the process
+// hal_nvsclear() wipes them to simulate a first boot
+
+#ifndef PREFERENCES_H_
+#define PREFERENCES_H_
+
+#include "Arduino.h"
+#include <map>
+#include <string>
+#include <vector>
+
+typedef std::map<std::string, std::vector<uint8_t> > halnvs;
+halnvs & hal_nvs(void);
+void hal_nvsclear(void);
+
+class Preferences
+{
+public:
+  bool begin(const char * name, bool = false)
+  {
+    space = name;
+    return true;
+  }
+  void end(void) {}
+  size_t putBytes(const char * key, const void * value, size_t len)
+  {
+    const uint8_t * p = (const uint8_t *)value;
+    hal_nvs()[space + "/" + key].assign(p, p + len);
+    return len;
+  }
+  size_t getBytesLength(const char * key)
+  {
+    halnvs::iterator i = hal_nvs().find(space + "/" + key);
+    return (i == hal_nvs().end()) ? 0 : i->second.size();
+  }
+  size_t getBytes(const char * key, void * buf, size_t maxLen)
+  {
+    halnvs::iterator i = hal_nvs().find(space + "/" + key);
+    if ((i == hal_nvs().end()) || (i->second.size() > maxLen)) return 0;
+    memcpy(buf, i->second.data(), i->second.size());
+    return i->second.size();
+  }
+  bool remove(const char * key) { return hal_nvs().erase(space + "/" + key) != 0; }
+
+private:
+  std::string space;
+};
+
+#endif // PREFERENCES_H_
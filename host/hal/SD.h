@@ -0,0 +1,117 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// ESP32 SD library stand-in for the host build - a card whose files live in memory for the life of the process
+// hal_sdclear() wipes it to simulate a blank card, hal_sdpresent(false) to simulate no card
+
+#ifndef SD_H_
+#define SD_H_
+
+#include "Arduino.h"
+#include "SPI.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+typedef std::vector<uint8_t> halsdfile;
+typedef std::map<std::string, std::shared_ptr<halsdfile> > halsdcard;
+halsdcard & hal_sdcard(void);
+void hal_sdclear(void);
+void hal_sdpresent(bool present);
+bool hal_sdinserted(void);
+
+class File
+{
+public:
+  File() : pos(0), writable(false) {}
+  File(std::shared_ptr<halsdfile> f, bool w) : data(f), pos(0), writable(w) {}
+  operator bool() const { return data != nullptr; }
+  size_t read(uint8_t * buf, size_t len)
+  {
+    if (!data || (pos >= data->size())) return 0;
+    if (len > data->size() - pos) len = data->size() - pos;
+    memcpy(buf, data->data() + pos, len);
+    pos += len;
+    return len;
+  }
+  size_t write(const uint8_t * buf, size_t len)
+  {
+    if (!data || !writable) return 0;
+    if (pos + len > data->size()) data->resize(pos + len);
+    memcpy(data->data() + pos, buf, len);
+    pos += len;
+    return len;
+  }
+  bool seek(uint32_t offset)
+  {
+    if (!data || (offset > data->size())) return false;
+    pos = offset;
+    return true;
+  }
+  size_t size(void) const { return data ? data->size() : 0; }
+  size_t position(void) const { return pos; }
+  void flush(void) {}
+  void close(void) { data.reset(); }
+
+private:
+  std::shared_ptr<halsdfile> data;  // shared with the card so a removed file stays readable until it's closed
+  size_t pos;
+  bool writable;
+};
+
+class SDFS
+{
+public:
+  bool begin(uint8_t = 0) { return hal_sdinserted(); }
+  bool begin(uint8_t, SPIClass &) { return hal_sdinserted(); }
+  void end(void) {}
+  bool exists(const char * path) { return hal_sdinserted() && hal_sdcard().count(path); }
+  bool remove(const char * path) { return hal_sdinserted() && hal_sdcard().erase(path); }
+  File open(const char * path, const char * mode = FILE_READ)
+  {
+    if (!hal_sdinserted()) return File();
+    std::string m(mode);
+    halsdcard::iterator i = hal_sdcard().find(path);
+    if ((m == "r") || (m == "r+")) {
+      if (i == hal_sdcard().end()) return File();
+      return File(i->second, m == "r+");
+    }
+    std::shared_ptr<halsdfile> & f = hal_sdcard()[path];
+    if (!f || (m != "a")) f.reset(new halsdfile);  // "w" starts a new file, "a" keeps what was there
+    File file(f, true);
+    file.seek(f->size());
+    return file;
+  }
+};
+
+extern SDFS SD;
+
+#endif // SD_H_
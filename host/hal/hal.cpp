@@ -0,0 +1,594 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// host implementation of the Arduino/ESP32 stand-in in Arduino.h
+
+#include "Arduino.h"
+#include "LiquidCrystal.h"
+#include "Preferences.h"
+#include "SD.h"
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+HardwareSerial Serial(0), Serial1(1), Serial2(2);
+
+// ----------------------------------------------------------------------------
+// clock
+
+#define HAL_YIELD_US 10    // a yield() while the sketch waits for something
+#define HAL_SPINS 10000    // clock reads without the clock moving before it creeps forward a us a read
+
+static uint64_t halnow;       // virtual clock in us, or us added by delay() to the host's clock in real time mode
+static uint32_t halspins;     // clock reads since the clock last moved
+static bool halreal;          // follow the host's clock
+static bool inisr;            // an ISR is running - no nested interrupts
+
+// host time in ns - for the CPU cost of the sketch and its ISRs, never for the sketch's clock
+uint64_t hal_hostnanos(void)
+{
+  static std::chrono::steady_clock::time_point halstart = std::chrono::steady_clock::now();
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - halstart).count();
+}
+
+void hal_realtime(void)
+{
+  halreal = true;
+}
+
+uint64_t hal_micros(void)
+{
+  return halreal ? hal_hostnanos() / 1000 + halnow : halnow;
+}
+
+// step the clock to each timer alarm on the way so the ISRs run as often and in the same order as they would have
+void hal_skip(uint32_t us)
+{
+  uint64_t end = hal_micros() + us;
+  halspins = 0;
+  for (;;) {
+    hal_poll();
+    uint64_t now = hal_micros();
+    if (now >= end) break;
+    uint64_t next = end;
+    for (uint8_t i = 0; i < 4; ++i) {
+      hw_timer_t * t = hal_timer(i);
+      if (t && t->enabled && (t->next > now) && (t->next < next)) next = t->next;
+    }
+    halnow += next - now;
+  }
+}
+
+// a read of the clock. a sketch spinning on it until some time has passed would never get there, so it creeps
+static uint64_t halclock(void)
+{
+  if (!halreal && !inisr && (++halspins > HAL_SPINS)) ++halnow;
+  hal_poll();
+  return hal_micros();
+}
+
+unsigned long millis(void)
+{
+  return (unsigned long)(halclock() / 1000);
+}
+
+unsigned long micros(void)
+{
+  return (unsigned long)halclock();
+}
+
+void delay(uint32_t ms)
+{
+  hal_skip(ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us)
+{
+  if (!inisr) hal_skip(us);  // the LCD strobe inside the timer ISR doesn't get to move the clock
+}
+
+void yield(void)
+{
+  if (halreal || inisr) hal_poll();
+  else hal_skip(HAL_YIELD_US);
+}
+
+// rate of the cycle counter trace.h reads on the host, measured once against the host's clock
+uint32_t hal_cyclemhz(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  static uint32_t mhz;
+  if (mhz == 0) {
+    uint64_t start = hal_hostnanos();
+    uint64_t c = __builtin_ia32_rdtsc();
+    while (hal_hostnanos() - start < 10000000);
+    mhz = (uint32_t)((__builtin_ia32_rdtsc() - c) * 1000 / (hal_hostnanos() - start));
+  }
+  return mhz ? mhz : 1;
+#else
+  return 1;  // trace.h counts micros()
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// hardware timers
+
+static hw_timer_t haltimers[4];
+
+hw_timer_t * timerBegin(uint8_t num, uint16_t divider, bool)
+{
+  hw_timer_t * t = &haltimers[num & 3];
+  memset(t, 0, sizeof(*t));
+  t->num = num;
+  t->divider = divider;
+  return t;
+}
+
+void timerAttachInterrupt(hw_timer_t * timer, void (*isr)(void), bool)
+{
+  timer->isr = isr;
+}
+
+void timerAlarmWrite(hw_timer_t * timer, uint64_t alarm, bool autoreload)
+{
+  timer->alarm = alarm;
+  timer->autoreload = autoreload;
+}
+
+// alarm period in us
+static uint64_t timerperiod(hw_timer_t * t)
+{
+  uint64_t us = t->alarm * t->divider / 80;
+  return us ? us : 1;
+}
+
+void timerAlarmEnable(hw_timer_t * timer)
+{
+  timer->enabled = true;
+  timer->next = hal_micros() + timerperiod(timer);
+}
+
+void timerAlarmDisable(hw_timer_t * timer)
+{
+  timer->enabled = false;
+}
+
+hw_timer_t * hal_timer(uint8_t num)
+{
+  hw_timer_t * t = &haltimers[num & 3];
+  return t->isr ? t : NULL;
+}
+
+// run a due ISR once and time its CPU cost. like the ESP32 interrupt flag, alarms that come due while one is pending are lost
+void hal_poll(void)
+{
+  if (inisr) return;
+  uint64_t now = hal_micros();
+  for (uint8_t i = 0; i < 4; ++i) {
+    hw_timer_t * t = &haltimers[i];
+    if (!t->enabled || !t->isr || (now < t->next)) continue;
+    uint64_t period = timerperiod(t);
+    uint64_t late = (now - t->next) / period;
+    t->missed += late;
+    t->next += (late + 1) * period;
+    if (!t->autoreload) t->enabled = false;
+    inisr = true;
+    uint64_t start = hal_hostnanos();
+    t->isr();
+    uint32_t ns = hal_hostnanos() - start;
+    inisr = false;
+    ++t->calls;
+    t->nanos += ns;
+    if (ns > t->maxnanos) t->maxnanos = ns;
+  }
+}
+
+// ----------------------------------------------------------------------------
+// pins
+
+static uint8_t pinlevel[HAL_PINS];
+static uint16_t analoglevel[HAL_PINS];
+static uint16_t analognoise[HAL_PINS];
+static uint64_t adcstarted;   // the one A/D conversion in progress
+static uint8_t adcpin = 0xff;
+static void (*pinisr[HAL_PINS])(void *);
+static void * pinarg[HAL_PINS];
+static int pinisrmode[HAL_PINS];
+static void lcdstrobe(void);
+static uint8_t lcdenable = 0xff;
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  if (pin >= HAL_PINS) return;
+  if (mode & PULLUP) pinlevel[pin] = HIGH;  // nothing pressed, encoders resting on a detent
+}
+
+int digitalRead(uint8_t pin)
+{
+  hal_poll();
+  return (pin < HAL_PINS) ? pinlevel[pin] : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+  if (pin >= HAL_PINS) return;
+  uint8_t was = pinlevel[pin];
+  pinlevel[pin] = val ? HIGH : LOW;
+  if ((pin == lcdenable) && was && !val) lcdstrobe();  // HD44780 latches on the falling edge of E
+}
+
+// a reading with the pin's noise added
+static uint16_t analogsample(uint8_t pin)
+{
+  if (pin >= HAL_PINS) return 0;
+  int32_t v = analoglevel[pin];
+  if (analognoise[pin]) v += (int32_t)(rand() % (2 * analognoise[pin] + 1)) - analognoise[pin];
+  return (v < 0) ? 0 : (v > 4095) ? 4095 : v;
+}
+
+uint16_t analogRead(uint8_t pin)
+{
+  hal_poll();
+  return analogsample(pin);
+}
+
+// non blocking A/D - a conversion takes about 10us like the ESP32's
+bool adcAttachPin(uint8_t pin)
+{
+  return pin < HAL_PINS;
+}
+
+bool adcStart(uint8_t pin)
+{
+  if (pin >= HAL_PINS) return false;
+  adcpin = pin;
+  adcstarted = hal_micros();
+  return true;
+}
+
+bool adcBusy(uint8_t pin)
+{
+  return (pin == adcpin) && ((hal_micros() - adcstarted) < 10);
+}
+
+uint16_t adcEnd(uint8_t pin)
+{
+  adcpin = 0xff;
+  return analogsample(pin);
+}
+
+int digitalPinToInterrupt(uint8_t pin)
+{
+  return (pin < HAL_PINS) ? pin : -1;
+}
+
+void attachInterruptArg(uint8_t pin, void (*isr)(void *), void * arg, int mode)
+{
+  if (pin >= HAL_PINS) return;
+  pinisr[pin] = isr;
+  pinarg[pin] = arg;
+  pinisrmode[pin] = mode;
+}
+
+void detachInterrupt(uint8_t pin)
+{
+  if (pin < HAL_PINS) pinisr[pin] = NULL;
+}
+
+void hal_setpin(uint8_t pin, uint8_t level)
+{
+  if (pin >= HAL_PINS) return;
+  uint8_t was = pinlevel[pin];
+  pinlevel[pin] = level ? HIGH : LOW;
+  if ((was == pinlevel[pin]) || !pinisr[pin] || inisr) return;
+  int edge = level ? RISING : FALLING;
+  if (pinisrmode[pin] & edge) {
+    inisr = true;
+    pinisr[pin](pinarg[pin]);
+    inisr = false;
+  }
+}
+
+void hal_setanalog(uint8_t pin, uint16_t val, uint16_t noise)
+{
+  if (pin >= HAL_PINS) return;
+  analoglevel[pin] = val;
+  analognoise[pin] = noise;
+}
+
+// ----------------------------------------------------------------------------
+// HD44780 - 20x4, 4 bit interface. only DDRAM address and data writes are decoded
+
+static uint8_t lcdpins[5];      // RS, D4-D7
+static uint8_t lcdddram[128];
+static uint8_t lcdaddress;
+static int16_t lcdhigh = -1;    // first nibble of a byte, -1 if waiting for one
+static uint32_t lcdcount;
+static char lcdtext[21];
+
+void hal_lcdattach(uint8_t rs, uint8_t enable, uint8_t d4, uint8_t d5, uint8_t d6, uint8_t d7)
+{
+  lcdpins[0] = rs;
+  lcdpins[1] = d4;
+  lcdpins[2] = d5;
+  lcdpins[3] = d6;
+  lcdpins[4] = d7;
+  lcdenable = enable;
+}
+
+void hal_lcdcommand(uint8_t cmd)
+{
+  if (cmd & 0x80) lcdaddress = cmd & 0x7f;
+  else if (cmd == 0x01) {
+    memset(lcdddram, ' ', sizeof(lcdddram));
+    lcdaddress = 0;
+  }
+  else if (cmd == 0x02) lcdaddress = 0;
+}
+
+void hal_lcdwrite(uint8_t c)
+{
+  lcdddram[lcdaddress] = c;
+  lcdaddress = (lcdaddress + 1) & 0x7f;
+}
+
+static void lcdstrobe(void)
+{
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < 4; ++i) n |= pinlevel[lcdpins[i + 1]] << i;
+  if (lcdhigh < 0) {
+    lcdhigh = n;
+    return;
+  }
+  uint8_t b = (lcdhigh << 4) | n;
+  lcdhigh = -1;
+  ++lcdcount;
+  if (pinlevel[lcdpins[0]]) hal_lcdwrite(b);
+  else hal_lcdcommand(b);
+}
+
+const char * hal_lcdrow(uint8_t row)
+{
+  static const uint8_t rowoffsets[] = {0x00, 0x40, 0x14, 0x54};
+  memcpy(lcdtext, &lcdddram[rowoffsets[row & 3]], 20);
+  lcdtext[20] = 0;
+  return lcdtext;
+}
+
+uint32_t hal_lcdbytes(void)
+{
+  return lcdcount;
+}
+
+// ----------------------------------------------------------------------------
+// NVS
+
+halnvs & hal_nvs(void)
+{
+  static halnvs nvs;
+  return nvs;
+}
+
+void hal_nvsclear(void)
+{
+  hal_nvs().clear();
+}
+
+// ----------------------------------------------------------------------------
+// SD card
+
+SDFS SD;
+static bool sdpresent = true;
+
+halsdcard & hal_sdcard(void)
+{
+  static halsdcard card;
+  return card;
+}
+
+void hal_sdclear(void)
+{
+  hal_sdcard().clear();
+}
+
+void hal_sdpresent(bool present)
+{
+  sdpresent = present;
+}
+
+bool hal_sdinserted(void)
+{
+  return sdpresent;
+}
+
+// ----------------------------------------------------------------------------
+// UARTs
+
+// set a tty's speed if termios has it, 500000 is there on Linux
+static void halttyspeed(int fd, unsigned long baud)
+{
+  static const struct {
+    unsigned long baud;
+    speed_t speed;
+  } speeds[] = {{9600, B9600}, {38400, B38400}, {115200, B115200}, {230400, B230400},
+#ifdef B500000
+                {500000, B500000},
+#endif
+  };
+  struct termios t;
+  if (tcgetattr(fd, &t) != 0) return;
+  for (size_t i = 0; i < sizeof(speeds) / sizeof(speeds[0]); ++i) {
+    if (speeds[i].baud != baud) continue;
+    cfsetispeed(&t, speeds[i].speed);
+    cfsetospeed(&t, speeds[i].speed);
+    tcsetattr(fd, TCSANOW, &t);
+  }
+}
+
+#define HAL_FIFO 128  // ESP32 UART TX FIFO
+
+HardwareSerial::HardwareSerial(uint8_t uart)
+  : ontx(NULL), txarg(NULL), txbytes(0), rxbytes(0), txwaits(0), uart(uart), fd(-1), baud(115200), fifo(0), drained(0),
+    txtime(0)
+{
+}
+
+void HardwareSerial::begin(unsigned long baud, uint32_t, int8_t, int8_t)
+{
+  this->baud = baud;
+  fifo = 0;
+  drained = hal_micros();
+  if (fd >= 0) halttyspeed(fd, baud);
+}
+
+// connect to a tty - raw, non blocking, at the baud rate begin() was or will be called with
+bool HardwareSerial::hal_open(const char * path)
+{
+  fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (fd < 0) return false;
+  struct termios t;
+  if (tcgetattr(fd, &t) == 0) {  // a pty master doesn't care
+    cfmakeraw(&t);
+    tcsetattr(fd, TCSANOW, &t);
+  }
+  halttyspeed(fd, baud);
+  return true;
+}
+
+// take out of the FIFO what the wire has sent since the last look - 10 bits a byte
+void HardwareSerial::drain(void)
+{
+  uint64_t now = hal_micros();
+  uint64_t sent = (now - drained) * baud / 10000000;
+  if (sent >= fifo) {
+    fifo = 0;
+    drained = now;
+  }
+  else {
+    fifo -= sent;
+    drained += sent * 10000000 / baud;
+  }
+}
+
+// pick up whatever the tty has
+void HardwareSerial::receive(void)
+{
+  if (fd < 0) return;
+  uint8_t buf[256];
+  ssize_t n;
+  while ((n = ::read(fd, buf, sizeof(buf))) > 0) hal_inject(buf, n);
+}
+
+int HardwareSerial::available(void)
+{
+  hal_poll();
+  receive();
+  uint64_t now = hal_micros();
+  int n = 0;
+  for (std::deque<rxbyte>::iterator i = rx.begin(); (i != rx.end()) && (i->at <= now); ++i) ++n;
+  return n;
+}
+
+int HardwareSerial::read(void)
+{
+  hal_poll();
+  receive();
+  if (rx.empty() || (rx.front().at > hal_micros())) return -1;
+  uint8_t c = rx.front().c;
+  rx.pop_front();
+  ++rxbytes;
+  return c;
+}
+
+int HardwareSerial::peek(void)
+{
+  receive();
+  return (rx.empty() || (rx.front().at > hal_micros())) ? -1 : rx.front().c;
+}
+
+int HardwareSerial::availableForWrite(void)
+{
+  hal_poll();
+  drain();
+  return HAL_FIFO - fifo;
+}
+
+void HardwareSerial::flush(void)
+{
+  while (availableForWrite() < HAL_FIFO) yield();
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+  if (uart == 0) {  // the console
+    fputc(c, stderr);
+    return 1;
+  }
+  if (availableForWrite() == 0) {
+    ++txwaits;
+    while (availableForWrite() == 0) yield();
+  }
+  ++fifo;
+  ++txbytes;
+  txtime = drained + (uint64_t)fifo * 10000000 / baud;
+  if (fd >= 0) {
+    while ((::write(fd, &c, 1) != 1) && (errno == EAGAIN)) yield();
+  }
+  if (ontx) ontx(c, txarg);
+  return 1;
+}
+
+// bytes arrive in order - one can't be in the FIFO before the one ahead of it
+void HardwareSerial::hal_inject(uint8_t c, uint64_t at)
+{
+  if (!rx.empty() && (at < rx.back().at)) at = rx.back().at;
+  rxbyte b = {at, c};
+  rx.push_back(b);
+}
+
+void HardwareSerial::hal_inject(const uint8_t * buf, size_t n, uint64_t at)
+{
+  for (size_t i = 0; i < n; ++i) hal_inject(buf[i], at);
+}
+
+void hal_resetstats(void)
+{
+  for (uint8_t i = 0; i < 4; ++i) {
+    haltimers[i].calls = 0;
+    haltimers[i].missed = 0;
+    haltimers[i].nanos = 0;
+    haltimers[i].maxnanos = 0;
+  }
+  HardwareSerial * ports[] = {&Serial, &Serial1, &Serial2};
+  for (uint8_t i = 0; i < 3; ++i) {
+    ports[i]->txbytes = 0;
+    ports[i]->rxbytes = 0;
+    ports[i]->txwaits = 0;
+  }
+  lcdcount = 0;
+}
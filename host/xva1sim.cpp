@@ -0,0 +1,176 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// XVA1 stand-in - see xva1sim.h
+
+#include "xva1sim.h"
+#include "Arduino.h"
+
+struct simconfig sim = {0, 0, 0, 500000, false, 1, NULL, 0};
+struct simstats simstat;
+uint8_t simimage[SIM_PARAMS];
+uint8_t simslots[SIM_SLOTS][SIM_PARAMS];
+uint8_t siminit[SIM_PARAMS];
+void (*sim_onapply)(uint16_t param, uint8_t val, uint64_t at);
+
+static void (*simsend)(uint8_t c, uint64_t at, void * arg);
+static void * simarg;
+static uint8_t simcmd;       // command being received, 0 if waiting for one
+static uint8_t simargs[3];
+static uint8_t simargc;
+static uint64_t simbusy;     // when the last reply byte is out - replies don't overlap
+static uint32_t simrandom;
+static uint8_t simdropnext;  // next entry of sim.droplist
+
+// xorshift - the same sequence on every host for a given seed
+static uint32_t simrand(void)
+{
+  simrandom ^= simrandom << 13;
+  simrandom ^= simrandom >> 17;
+  simrandom ^= simrandom << 5;
+  return simrandom;
+}
+
+// send a reply to a command that finished arriving at time at
+static void simreply(const uint8_t * buf, uint16_t n, uint64_t at)
+{
+  if (sim.dead) return;
+  uint64_t t = at + sim.latency + (sim.jitter ? simrand() % (sim.jitter + 1) : 0);
+  if (t < simbusy) t = simbusy;
+  uint32_t bytetime = 10000000 / sim.baud;
+  for (uint16_t i = 0; i < n; ++i) {
+    t += bytetime;
+    ++simstat.replies;
+    bool listed = (simdropnext < sim.dropcount) && (sim.droplist[simdropnext] == simstat.replies);
+    if (listed) ++simdropnext;
+    if (listed || (sim.droprate && ((simrand() % 10000) < sim.droprate))) {
+      ++simstat.dropped;
+      continue;
+    }
+    ++simstat.sent;
+    if (simsend) simsend(buf[i], t, simarg);
+  }
+  simbusy = t;
+}
+
+static void simack(uint64_t at)
+{
+  static const uint8_t ack = 0;
+  simreply(&ack, 1, at);
+}
+
+static void simapply(uint16_t param, uint8_t val, uint64_t at)
+{
+  simimage[param] = val;
+  ++simstat.frames;
+  if (sim_onapply) sim_onapply(param, val, at);
+}
+
+void sim_rx(uint8_t c, uint64_t at)
+{
+  if (simcmd == 0) {
+    simargc = 0;
+    switch (c) {
+      case 'd':
+        ++simstat.dumps;
+        simreply(simimage, SIM_PARAMS, at);
+        break;
+      case 'i':
+        ++simstat.inits;
+        memcpy(simimage, siminit, SIM_PARAMS);
+        simack(at);
+        break;
+      case 's':
+      case 'r':
+      case 'w':
+        simcmd = c;
+        break;
+      default:
+        ++simstat.junk;
+        break;
+    }
+    return;
+  }
+  simargs[simargc++] = c;
+  switch (simcmd) {
+    case 's':  // address, value or 255, address-256, value
+      if ((simargc == 2) && (simargs[0] != 255)) simapply(simargs[0], simargs[1], at);
+      else if (simargc == 3) simapply(256 + simargs[1], simargs[2], at);
+      else return;
+      break;
+    case 'r':
+      ++simstat.reads;
+      memcpy(simimage, simslots[c % SIM_SLOTS], SIM_PARAMS);
+      simack(at);
+      break;
+    case 'w':
+      ++simstat.writes;
+      memcpy(simslots[c % SIM_SLOTS], simimage, SIM_PARAMS);
+      simack(at);
+      break;
+  }
+  simcmd = 0;
+}
+
+void sim_resetstats(void)
+{
+  memset(&simstat, 0, sizeof(simstat));
+  simdropnext = 0;
+}
+
+// slot s gets a different recognizable pattern in every slot, init is mostly zeros
+void sim_begin(void (*send)(uint8_t c, uint64_t at, void * arg), void * arg)
+{
+  simsend = send;
+  simarg = arg;
+  simcmd = 0;
+  simbusy = 0;
+  simrandom = sim.seed ? sim.seed : 1;
+  for (uint16_t s = 0; s < SIM_SLOTS; ++s) {
+    for (uint16_t i = 0; i < SIM_PARAMS; ++i) simslots[s][i] = (i * 7 + s) & 0x7f;
+  }
+  memset(siminit, 0, sizeof(siminit));
+  siminit[1] = 1;  // oscillator 1 on
+  memcpy(simimage, simslots[0], SIM_PARAMS);
+  sim_resetstats();
+}
+
+static void simportsend(uint8_t c, uint64_t at, void * arg)
+{
+  ((HardwareSerial *)arg)->hal_inject(c, at);
+}
+
+static void simporttx(uint8_t c, void * arg)
+{
+  sim_rx(c, ((HardwareSerial *)arg)->hal_txtime());
+}
+
+void sim_attach(HardwareSerial & port)
+{
+  sim_begin(simportsend, &port);
+  port.ontx = simporttx;
+  port.txarg = &port;
+}
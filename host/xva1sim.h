@@ -0,0 +1,84 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// XVA1 stand-in - the FPGA end of the Serial2 protocol for the host build and the benchmarks
+// 's' set (address 255 escapes to a second byte for 256 and up), 'd' 512 byte dump, 'r' read slot, 'w' write slot, 'i' init
+// 'r', 'w' and 'i' answer with one 0 byte like the XVA1. replies start sim.latency us after the command is in, plus up to
+// sim.jitter us at random, and go out at sim.baud. sim.droprate of every 10000 reply bytes are lost on the way, and
+// the reply bytes numbered in sim.droplist - a fixed pattern for checks that have to hit a given ack or dump
+// all the times are the HAL's clock - in process that is the bench's virtual clock, so a given seed is the same run
+// the transport is up to the caller: sim_rx() takes the bytes the editor sent with the time they arrived and the send
+// hook gets each reply byte with the time it arrives at the other end. sim_attach() wires it to a HardwareSerial in
+// the same process, xva1sim (xva1simmain.cpp) puts it on a pseudo-terminal
+
+#ifndef XVA1SIM_H_
+#define XVA1SIM_H_
+
+#include <stdint.h>
+
+#define SIM_PARAMS 512
+#define SIM_SLOTS 128
+
+struct simconfig {
+  uint32_t latency;    // us from the last byte of a command to the first byte of its reply
+  uint32_t jitter;     // up to this many us more, at random
+  uint16_t droprate;   // reply bytes lost per 10000
+  uint32_t baud;       // reply wire speed
+  bool dead;           // powered off - takes everything, answers nothing
+  uint32_t seed;       // for the jitter and the drops, the same seed gives the same run
+  const uint32_t * droplist;  // reply bytes to lose, numbered from 1 at sim_resetstats(), in increasing order
+  uint8_t dropcount;   // entries in droplist
+};
+
+struct simstats {
+  uint32_t frames;     // 's' frames applied
+  uint32_t dumps;
+  uint32_t reads;
+  uint32_t writes;
+  uint32_t inits;
+  uint32_t junk;       // bytes that weren't a command
+  uint32_t sent;       // reply bytes sent
+  uint32_t dropped;    // reply bytes lost
+  uint32_t replies;    // reply bytes sent or lost - the numbering of droplist
+};
+
+extern struct simconfig sim;
+extern struct simstats simstat;
+extern uint8_t simimage[SIM_PARAMS];           // edit buffer
+extern uint8_t simslots[SIM_SLOTS][SIM_PARAMS];  // patch memory
+extern uint8_t siminit[SIM_PARAMS];            // what 'i' loads
+
+// called when an 's' frame lands in the edit buffer, at is when its last byte arrived. can be NULL
+extern void (*sim_onapply)(uint16_t param, uint8_t val, uint64_t at);
+
+void sim_begin(void (*send)(uint8_t c, uint64_t at, void * arg), void * arg);
+void sim_rx(uint8_t c, uint64_t at);
+void sim_resetstats(void);
+
+class HardwareSerial;
+void sim_attach(HardwareSerial & port);  // in process - the port's TX feeds the XVA1, replies land in its RX
+
+#endif // XVA1SIM_H_
@@ -0,0 +1,121 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// xva1sim - the XVA1 stand-in on a pseudo-terminal
+// prints the name of the terminal to connect to, then answers the XVA1 protocol on it until killed. point
+// "xva1bench -p" or anything else that talks to an XVA1 at it. ctrl-C prints what it saw
+//
+// usage: xva1sim [-l latency us] [-j jitter us] [-d drops per 10000] [-b baud] [-s seed] [-x]
+//   -x plays a powered off synth
+
+#include "xva1sim.h"
+#include "Arduino.h"
+#include <deque>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+
+struct pending {
+  uint64_t at;
+  uint8_t c;
+};
+
+static std::deque<pending> outq;
+static volatile bool quit;
+
+static void queue(uint8_t c, uint64_t at, void *)
+{
+  pending p = {at, c};
+  outq.push_back(p);
+}
+
+static void stop(int)
+{
+  quit = true;
+}
+
+int main(int argc, char ** argv)
+{
+  int opt;
+  while ((opt = getopt(argc, argv, "l:j:d:b:s:x")) != -1) {
+    switch (opt) {
+      case 'l': sim.latency = strtoul(optarg, NULL, 0); break;
+      case 'j': sim.jitter = strtoul(optarg, NULL, 0); break;
+      case 'd': sim.droprate = strtoul(optarg, NULL, 0); break;
+      case 'b': sim.baud = strtoul(optarg, NULL, 0); break;
+      case 's': sim.seed = strtoul(optarg, NULL, 0); break;
+      case 'x': sim.dead = true; break;
+      default:
+        fprintf(stderr, "usage: %s [-l latency us] [-j jitter us] [-d drops per 10000] [-b baud] [-s seed] [-x]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  hal_realtime();  // the other end of the pty runs in real time
+  int fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if ((fd < 0) || grantpt(fd) || unlockpt(fd)) {
+    perror("pty");
+    return 1;
+  }
+  struct termios t;
+  tcgetattr(fd, &t);
+  cfmakeraw(&t);
+  tcsetattr(fd, TCSANOW, &t);
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+  printf("%s\n", ptsname(fd));
+  fflush(stdout);
+
+  signal(SIGINT, stop);
+  signal(SIGTERM, stop);
+  sim_begin(queue, NULL);
+
+  while (!quit) {
+    uint64_t now = hal_micros();
+    while (!outq.empty() && (outq.front().at <= now)) {
+      if (write(fd, &outq.front().c, 1) != 1) break;  // the other end isn't reading - try again later
+      outq.pop_front();
+    }
+    int wait = 100;
+    if (!outq.empty()) wait = (outq.front().at > now) ? (int)((outq.front().at - now) / 1000) : 0;
+    struct pollfd p = {fd, POLLIN, 0};
+    if (poll(&p, 1, wait) <= 0) continue;
+    if (!(p.revents & POLLIN)) {  // nobody has the terminal open
+      usleep(10000);
+      continue;
+    }
+    uint8_t buf[256];
+    ssize_t n = read(fd, buf, sizeof(buf));
+    now = hal_micros();
+    for (ssize_t i = 0; i < n; ++i) sim_rx(buf[i], now);
+  }
+
+  fprintf(stderr, "\n%u frames, %u dumps, %u reads, %u writes, %u inits, %u junk bytes, %u bytes sent, %u dropped\n",
+          simstat.frames, simstat.dumps, simstat.reads, simstat.writes, simstat.inits, simstat.junk, simstat.sent,
+          simstat.dropped);
+  return 0;
+}
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+# generate xva1_LCDV3/paramtable.h from tools/xva1params.csv
+# usage: python3 tools/genparams.py [csv] [header]
+#
+# every synth parameter 0-511 gets an entry in paramtable[], in parameter number order so parameter p is always entry p.
+# the table is for lookups, not a menu - the parameters it describes are the ones the hand made menus in menusystem.h
+# already have, so it gives MIDI remote control their ranges. undescribed ones are TYPE_NONE with range 255.
+# label lists that menusystem.h already has a text table for use that table, the others are emitted once each
+
+import csv
+import os
+import re
+import sys
+
+PARAMS = 512
+
+here = os.path.dirname(os.path.abspath(__file__))
+src = sys.argv[1] if len(sys.argv) > 1 else os.path.join(here, 'xva1params.csv')
+dst = sys.argv[2] if len(sys.argv) > 2 else os.path.join(here, '..', 'xva1_LCDV3', 'paramtable.h')
+menus = os.path.join(os.path.dirname(os.path.abspath(dst)), 'menusystem.h')
+
+
+def fail(line, msg):
+    sys.exit('%s:%d: %s' % (src, line, msg))
+
+
+def cstr(s):
+    return '"' + s.replace('\\', '\\\\').replace('"', '\\"') + '"'
+
+
+params = {}
+with open(src, newline='') as f:
+    lines = [(n, line) for n, line in enumerate(f, 1) if not line.startswith('#')]
+    rows = csv.reader(line for n, line in lines)
+    header = next(rows)
+    for row in rows:
+        n = lines[rows.line_num - 1][0]   # line number in the file, comments included
+        if not row:
+            continue
+        rec = dict(zip(header, row))
+        num = int(rec['number'])
+        rng = int(rec['range'])
+        labels = rec['labels'].split('|') if rec['labels'] else []
+        if not 1 <= num < PARAMS:
+            fail(n, 'parameter %d out of range' % num)
+        if num in params:
+            fail(n, 'parameter %d listed twice' % num)
+        if not 0 <= rng <= 255:
+            fail(n, 'range %d does not fit a byte' % rng)
+        if labels and len(labels) <= rng:
+            fail(n, 'parameter %d has %d labels for range %d' % (num, len(labels), rng))
+        if len(rec['longname']) > 20:
+            print('%s:%d: warning: long name "%s" is cut off on the LCD' % (src, n, rec['longname']), file=sys.stderr)
+        params[num] = (rec['name'], rec['longname'], rng, labels, rec['group'])
+
+# the hand made text tables - paramtable.h is included after them
+texttables = {}
+with open(menus) as f:
+    for name, body in re.findall(r'constexpr const char \* (\w+)\[\] = \{(.*?)\};', f.read(), re.S):
+        labels = re.findall(r'"((?:[^"\\]|\\.)*)"', body)
+        texttables.setdefault(tuple(labels), name)
+
+labeltables = []   # label lists menusystem.h doesn't have, in order of first use
+def labeltable(labels):
+    if tuple(labels) in texttables:
+        return texttables[tuple(labels)]
+    if labels not in labeltables:
+        labeltables.append(labels)
+    return 'paramlabels%d' % labeltables.index(labels)
+
+def entry(num):
+    name, longname, rng, labels, group = params[num]
+    if labels:
+        return '  %s,%s,%d,TYPE_TEXT,%s,%d,   // %s' % (cstr(name), cstr(longname), rng, labeltable(labels), num, group)
+    return '  %s,%s,%d,TYPE_NUM,0,%d,   // %s' % (cstr(name), cstr(longname), rng, num, group)
+
+entries = []
+for num in range(PARAMS):
+    if num == 0:
+        entries.append('  "    ","",1,TYPE_NONE,0,DUMMY,   // 0 is not used by the synth')
+    elif num in params:
+        entries.append(entry(num))
+    else:
+        entries.append('  "    ","Parameter %d",255,TYPE_NONE,0,%d,   // not described' % (num, num))
+
+out = []
+out.append('// generated by tools/genparams.py from tools/xva1params.csv - edit the CSV and run the script again, don\'t edit this file')
+out.append('//')
+out.append('// paramtable[p] describes synth parameter p for lookups by number. %d parameters are described, the other %d are' % (len(params), PARAMS - 1 - len(params)))
+out.append('// TYPE_NONE with range 255')
+out.append('')
+out.append('#ifndef PARAMTABLE_H_')
+out.append('#define PARAMTABLE_H_')
+out.append('')
+out.append('#define PARAMTABLE_SIZE %d' % PARAMS)
+out.append('')
+for i, labels in enumerate(labeltables):
+    out.append('constexpr const char * paramlabels%d[] = {%s};' % (i, ','.join(cstr(l) for l in labels)))
+if labeltables:
+    out.append('')
+out.append('// for menusystem.h\'s list of text tables')
+out.append('#define PARAMTABLE_TEXTTABLES%s' % ''.join(' \\\n  TEXTTABLE(paramlabels%d),' % i for i in range(len(labeltables))))
+out.append('')
+out.append('constexpr struct submenu paramtable[] = {')
+out.append('// name,longname,range,display type,textfield *,parameter number')
+out.extend(entries)
+out.append('};')
+out.append('')
+out.append('#endif // PARAMTABLE_H_')
+
+with open(dst, 'w') as f:
+    f.write('\n'.join(out) + '\n')
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+# turn a trace dump (type "trace" on the debug serial port, see xva1_LCDV3/trace.h) into per stage latency histograms
+# usage: python3 tools/tracedecode.py [dump file]   reads stdin if no file is given
+#
+# lines that aren't part of a dump are skipped so a whole serial log can be fed in, and several dumps are added up.
+# begin/end pairs are matched per ring and per stage, nested stages are fine. a stage that was still open when the
+# ring wrapped or the dump was taken has no pair and is left out
+
+import sys
+
+src = open(sys.argv[1], errors='replace') if len(sys.argv) > 1 else sys.stdin
+
+durations = {}   # (ring, stage) -> list of us
+unpaired = 0
+mhz = None
+indump = False
+open_ = {}       # (ring, stage) -> stack of begin cycle counts
+
+for line in src:
+    f = line.split()
+    if len(f) >= 3 and f[0] == 'trace' and f[1] == 'mhz':
+        mhz = int(f[2]) or 1
+        indump = True
+        open_ = {}
+        continue
+    if not indump:
+        continue
+    if f == ['trace', 'end']:
+        unpaired += sum(len(v) for v in open_.values())
+        indump = False
+        continue
+    if len(f) != 4 or f[0] not in ('L', 'I') or f[2] not in ('B', 'E'):
+        continue
+    ring, cycles, kind, stage = f[0], int(f[1], 16), f[2], f[3]
+    key = (ring, stage)
+    if kind == 'B':
+        open_.setdefault(key, []).append(cycles)
+    elif open_.get(key):
+        begin = open_[key].pop()
+        durations.setdefault(key, []).append(((cycles - begin) & 0xffffffff) / mhz)
+    else:
+        unpaired += 1
+
+if mhz is None:
+    sys.exit('no trace dump found')
+
+
+def pct(v, p):
+    return v[int(p * (len(v) - 1))]
+
+
+BUCKETS = [1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000]
+
+print('%-4s %-14s %7s %9s %9s %9s %9s %9s   %s' %
+      ('ring', 'stage', 'count', 'p50 us', 'p90 us', 'p99 us', 'max us', 'total us', 'histogram (us)'))
+for (ring, stage), v in sorted(durations.items(), key=lambda kv: -sum(kv[1])):
+    v.sort()
+    counts = [0] * (len(BUCKETS) + 1)
+    for d in v:
+        counts[next((i for i, b in enumerate(BUCKETS) if d < b), len(BUCKETS))] += 1
+    hist = ' '.join('<%d:%d' % (b, c) for b, c in zip(BUCKETS, counts) if c)
+    if counts[-1]:
+        hist += ' >=%d:%d' % (BUCKETS[-1], counts[-1])
+    print('%-4s %-14s %7d %9.2f %9.2f %9.2f %9.2f %9.1f   %s' %
+          ('loop' if ring == 'L' else 'isr', stage, len(v), pct(v, 0.5), pct(v, 0.9), pct(v, 0.99), v[-1], sum(v), hist))
+if unpaired:
+    print('%d events without a pair' % unpaired)
@@ -11,6 +11,11 @@
 
 #include "ClickEncoder.h"
 
+#if defined(ARDUINO_ARCH_ESP32)
+#  include "soc/soc.h"
+#  include "soc/gpio_reg.h"
+#endif
+
 // ----------------------------------------------------------------------------
 // Button configuration (values for 1ms timer service calls)
 //
@@ -19,119 +24,114 @@
 #define ENC_HOLDTIME        500  // report held button after 1s
 
 // ----------------------------------------------------------------------------
-// Acceleration configuration (for 1000Hz calls to ::service())
+// Acceleration configuration
+// deceleration is per millisecond so it doesn't depend on how often ::service() is called - at 1kHz it is the same as
+// the original per call decay
 //
 #define ENC_ACCEL_TOP      3072   // max. acceleration: *12 (val >> 8)
-#define ENC_ACCEL_INC        50
-#define ENC_ACCEL_DEC         2
-
-// ----------------------------------------------------------------------------
-
-#if ENC_DECODER != ENC_NORMAL
-#  ifdef ENC_HALFSTEP
-     // decoding table for hardware with flaky notch (half resolution)
-     const int8_t ClickEncoder::table[16] __attribute__((__progmem__)) = {
-       0, 0, -1, 0, 0, 0, 0, 1, 1, 0, 0, 0, 0, -1, 0, 0
-     };
-#  else
-     // decoding table for normal hardware
-     const int8_t ClickEncoder::table[16] __attribute__((__progmem__)) = {
-       0, 1, -1, 0, -1, 0, 0, 1, 1, 0, 0, -1, 0, -1, 1, 0
-     };
-#  endif
+#define ENC_ACCEL_INC        50   // per step
+#define ENC_ACCEL_DEC         2   // per millisecond
+
+// ----------------------------------------------------------------------------
+
+// decoding tables, indexed by previous A/B << 2 | current A/B
+// the normal table counts every valid gray code transition, same as Peter Dannegger's decoder
+//
+#if ENC_DECODER == ENC_FLAKY && defined(ENC_HALFSTEP)
+   // decoding table for hardware with flaky notch (half resolution)
+   const int8_t ClickEncoder::table[16] PROGMEM = {
+     0, 0, -1, 0, 0, 0, 0, 1, 1, 0, 0, 0, 0, -1, 0, 0
+   };
+#elif ENC_DECODER == ENC_FLAKY || ENC_DECODER == ENC_NORMAL
+   // decoding table for normal hardware
+   const int8_t ClickEncoder::table[16] PROGMEM = {
+     0, 1, -1, 0, -1, 0, 0, 1, 1, 0, 0, -1, 0, -1, 1, 0
+   };
+#else
+#  error "Error: define ENC_DECODER to ENC_NORMAL or ENC_FLAKY"
 #endif
 
+uint64_t ClickEncoder::usedPins = 0;
+
 // ----------------------------------------------------------------------------
 
 ClickEncoder::ClickEncoder(uint8_t A, uint8_t B, uint8_t BTN, uint8_t stepsPerNotch, bool active)
-  : doubleClickEnabled(true), accelerationEnabled(true),
-    delta(0), last(0), acceleration(0),
-    button(Open), steps(stepsPerNotch),
-    pinA(A), pinB(B), pinBTN(BTN), pinsActive(active)
+  : pinA(A), pinB(B), pinBTN(BTN), pinsActive(active),
+    delta(0), last(0), steps(stepsPerNotch), acceleration(0),
+    accelerationEnabled(true), button(Open), doubleClickEnabled(true)
 {
   uint8_t configType = (pinsActive == LOW) ? INPUT_PULLUP : INPUT;
   pinMode(pinA, configType);
   pinMode(pinB, configType);
   pinMode(pinBTN, configType);
 
-  if (digitalRead(pinA) == pinsActive) {
-    last = 3;
+  activeBits = (pinsActive == LOW) ? 3 : 0;
+  usedPins |= ((uint64_t)1 << pinA) | ((uint64_t)1 << pinB);
+  if (pinBTN < 64) {
+    usedPins |= (uint64_t)1 << pinBTN;
   }
 
-  if (digitalRead(pinB) == pinsActive) {
-    last ^=1;
-  }
+  uint64_t pins = readPins();
+  last = ((((uint32_t)(pins >> pinA) & 1) << 1) | ((uint32_t)(pins >> pinB) & 1)) ^ activeBits;
+  lastService = millis();
 }
 
 // ----------------------------------------------------------------------------
-// call this every 1 millisecond via timer ISR
+// snapshot of all GPIO inputs, bit n is pin n
+// on the ESP32 this is two register reads. elsewhere it falls back to digitalRead() of the pins the encoders use
 //
-void ClickEncoder::service(void)
+uint64_t ClickEncoder::readPins(void)
 {
-  bool moved = false;
-  unsigned long now = millis();
-
-  if (accelerationEnabled) { // decelerate every tick
-    acceleration -= ENC_ACCEL_DEC;
-    if (acceleration & 0x8000) { // handle overflow of MSB is set
-      acceleration = 0;
+#if defined(ARDUINO_ARCH_ESP32)
+  return REG_READ(GPIO_IN_REG) | ((uint64_t)(REG_READ(GPIO_IN1_REG) & 0xFF) << 32);
+#else
+  uint64_t pins = 0;
+  for (uint8_t p = 0; p < 64; p++) {
+    if (((usedPins >> p) & 1) && digitalRead(p)) {
+      pins |= (uint64_t)1 << p;
     }
   }
+  return pins;
+#endif
+}
 
-#if ENC_DECODER == ENC_FLAKY
-  last = (last << 2) & 0x0F;
-
-  if (digitalRead(pinA) == pinsActive) {
-    last |= 2;
-  }
-
-  if (digitalRead(pinB) == pinsActive) {
-    last |= 1;
-  }
-
-  uint8_t tbl = pgm_read_byte(&table[last]);
-  if (tbl) {
-    delta += tbl;
-    moved = true;
-  }
-#elif ENC_DECODER == ENC_NORMAL
-  int8_t curr = 0;
-
-  if (digitalRead(pinA) == pinsActive) {
-    curr = 3;
-  }
+// ----------------------------------------------------------------------------
+// call this every 1 millisecond via timer ISR
+// reads the pins itself - with several encoders use the version below with one readPins() for all of them
+//
+void ClickEncoder::service(void)
+{
+  service(readPins(), millis());
+}
 
-  if (digitalRead(pinB) == pinsActive) {
-    curr ^= 1;
+// ----------------------------------------------------------------------------
+// call this at 1kHz or faster via timer ISR
+// pins is a readPins() snapshot shared by all encoders, now is millis() at the time of the snapshot
+//
+void ClickEncoder::service(uint64_t pins, unsigned long now)
+{
+  if (accelerationEnabled) { // decelerate by the time since the last call
+    uint32_t dec = (uint32_t)(now - lastService) * ENC_ACCEL_DEC;
+    acceleration = (acceleration > dec) ? acceleration - dec : 0;
   }
+  lastService = now;
 
-  int8_t diff = last - curr;
-
-  if (diff & 1) {            // bit 0 = step
-    last = curr;
-    delta += (diff & 2) - 1; // bit 1 = direction (+/-)
-    moved = true;
-  }
-#else
-# error "Error: define ENC_DECODER to ENC_NORMAL or ENC_FLAKY"
+#if !ENC_EDGE_INTERRUPTS
+  decode(pins, now);
 #endif
 
-  if (accelerationEnabled && moved) {
-    // increment accelerator if encoder has been moved
-    if (acceleration <= (ENC_ACCEL_TOP - ENC_ACCEL_INC)) {
-      acceleration += ENC_ACCEL_INC;
-    }
-  }
-
   // handle button
   //
 #ifndef WITHOUT_BUTTON
-  if (pinBTN > 0 // check button only, if a pin has been provided
+  if (pinBTN > 0 && pinBTN < 64 // check button only, if a pin has been provided
       && (now - lastButtonCheck) >= ENC_BUTTONINTERVAL) // checking button is sufficient every 10-30ms
   {
+    Button previous = button;
     lastButtonCheck = now;
 
-    if (digitalRead(pinBTN) == pinsActive) { // key is down
+    bool down = (((pins >> pinBTN) & 1) == pinsActive);
+
+    if (down) { // key is down
       button=Closed;
       keyDownTicks++;
       if (keyDownTicks > (ENC_HOLDTIME / ENC_BUTTONINTERVAL)) {
@@ -139,7 +139,7 @@ void ClickEncoder::service(void)
       }
     }
 
-    if (digitalRead(pinBTN) == !pinsActive) { // key is now up
+    else { // key is now up
       if (keyDownTicks /*> ENC_BUTTONINTERVAL*/) {
         if (button == Held) {
           button = Released;
@@ -158,6 +158,9 @@ void ClickEncoder::service(void)
           }
         }
       }
+      if (button == Closed) {
+        button = Open;
+      }
 
       keyDownTicks = 0;
     }
@@ -168,39 +171,144 @@ void ClickEncoder::service(void)
         button = Clicked;
       }
     }
+
+    // Held, Released, Clicked and DoubleClicked go to loop() as events
+    // the last three are one shot states, the live state goes back to Open once they are queued
+    if (button != previous) {
+      if (button >= Held) {
+        pushEvent(EventButton, button, now);
+      }
+      if (button > Held) {
+        button = Open;
+      }
+    }
   }
 #endif // WITHOUT_BUTTON
 
 }
 
 // ----------------------------------------------------------------------------
+// quadrature decoder, called from ::service() or from the A/B pin change interrupt
+//
+void ClickEncoder::decode(uint64_t pins, unsigned long now)
+{
+  // shift the new A/B pair in behind the last one and look up the step
+  uint8_t ab = ((((uint32_t)(pins >> pinA) & 1) << 1) | ((uint32_t)(pins >> pinB) & 1)) ^ activeBits;
+  last = ((last << 2) | ab) & 0x0F;
+  int8_t step = pgm_read_byte(&table[last]);
+  delta += step;
+  bool moved = (step != 0);
 
-int16_t ClickEncoder::getValue(void)
+  if (accelerationEnabled && moved) {
+    // increment accelerator if encoder has been moved
+    if (acceleration <= (ENC_ACCEL_TOP - ENC_ACCEL_INC)) {
+      acceleration += ENC_ACCEL_INC;
+    }
+  }
+
+  // report a notch once enough steps have accumulated in one direction
+  if (moved) {
+    if (delta >= steps) {
+      delta -= steps;
+      pushEvent(EventRotate, 1, now);
+    }
+    else if (delta <= -steps) {
+      delta += steps;
+      pushEvent(EventRotate, -1, now);
+    }
+  }
+}
+
+#if ENC_EDGE_INTERRUPTS
+// ----------------------------------------------------------------------------
+
+void ICACHE_RAM_ATTR ClickEncoder::edgeISR(void *arg)
 {
-  int16_t val;
+  ((ClickEncoder *)arg)->decode(readPins(), millis());
+}
 
-  cli();
-  val = delta;
+void ClickEncoder::attachEdgeInterrupts(void)
+{
+  attachInterruptArg(digitalPinToInterrupt(pinA), edgeISR, this, CHANGE);
+  attachInterruptArg(digitalPinToInterrupt(pinB), edgeISR, this, CHANGE);
+}
+#endif
 
-  if (steps == 2) delta = val & 1;
-  else if (steps == 4) delta = val & 3;
-  else delta = 0; // default to 1 step per notch
+// ----------------------------------------------------------------------------
 
-  sei();
+void ClickEncoder::pushEvent(uint8_t type, int8_t value, unsigned long now)
+{
+  uint8_t used = eventHead - eventTail;
+  if (used >= ENC_EVENTS) { // full - loop() is too slow, drop the new event
+    overflows++;
+    return;
+  }
 
-  if (steps == 4) val >>= 2;
-  if (steps == 2) val >>= 1;
+  Event &ev = events[eventHead & (ENC_EVENTS - 1)];
+  ev.time = now;
+  ev.type = type;
+  ev.value = value;
+  ev.accel = (accelerationEnabled) ? (acceleration >> 8) : 0;
+  __asm__ __volatile__("" ::: "memory"); // event must be complete before loop() can see it
+  eventHead = eventHead + 1;
 
-  int16_t r = 0;
-  int16_t accel = ((accelerationEnabled) ? (acceleration >> 8) : 0);
+  if (used >= highWater) {
+    highWater = used + 1;
+  }
+}
 
-  if (val < 0) {
-    r -= 1 + accel;
+// ----------------------------------------------------------------------------
+
+bool ClickEncoder::getEvent(Event &ev)
+{
+  uint8_t tail = eventTail;
+  if (tail == eventHead) {
+    return false;
   }
-  else if (val > 0) {
-    r += 1 + accel;
+  ev = events[tail & (ENC_EVENTS - 1)];
+  __asm__ __volatile__("" ::: "memory"); // copy the event before the ISR may reuse the slot
+  eventTail = tail + 1;
+  return true;
+}
+
+// ----------------------------------------------------------------------------
+
+uint8_t ClickEncoder::drain(void)
+{
+  uint8_t n = 0;
+  Event ev;
+
+  while (getEvent(ev)) {
+    n++;
+    if (ev.type == EventRotate) {
+      notches += ev.value;
+      notchAccel = ev.accel;
+    }
+#ifndef WITHOUT_BUTTON
+    else if (buttonCount < sizeof(buttons) / sizeof(buttons[0])) {
+      buttons[buttonCount++] = (Button)ev.value;
+    }
+#endif
   }
+  return n;
+}
+
+// ----------------------------------------------------------------------------
 
+// same as the original polled getValue() - one step in the direction the encoder went since the last call, times the
+// acceleration at the last notch, however many notches that was
+//
+int16_t ClickEncoder::getValue(void)
+{
+  drain();
+  int16_t r = 0;
+  if (notches < 0) {
+    r -= 1 + notchAccel;
+  }
+  else if (notches > 0) {
+    r += 1 + notchAccel;
+  }
+  notches = 0;
   return r;
 }
 
@@ -209,10 +317,20 @@ int16_t ClickEncoder::getValue(void)
 #ifndef WITHOUT_BUTTON
 ClickEncoder::Button ClickEncoder::getButton(void)
 {
-  ClickEncoder::Button ret = button;
-  if (button != ClickEncoder::Held) {
-    button = ClickEncoder::Open; // reset
+  drain();
+  if (buttonCount) { // oldest event first so no click is lost
+    ClickEncoder::Button ret = buttons[0];
+    buttonCount--;
+    for (uint8_t i = 0; i < buttonCount; i++) {
+      buttons[i] = buttons[i + 1];
+    }
+    return ret;
+  }
+
+  ClickEncoder::Button live = button; // no events - report the button that is down
+  if (live == ClickEncoder::Held || live == ClickEncoder::Closed) {
+    return live;
   }
-  return ret;
+  return ClickEncoder::Open;
 }
 #endif
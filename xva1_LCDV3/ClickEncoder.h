@@ -37,6 +37,16 @@
 #  endif
 #endif
 
+// set to 1 to decode A/B from pin change interrupts instead of polling them in ::service()
+// the timer then only handles the button and acceleration decay, call attachEdgeInterrupts() in setup()
+#ifndef ENC_EDGE_INTERRUPTS
+#  define ENC_EDGE_INTERRUPTS 0
+#endif
+
+#ifndef ENC_EVENTS
+#  define ENC_EVENTS      16       // ISR to loop event ring size, must be a power of 2 <= 128
+#endif
+
 // ----------------------------------------------------------------------------
 
 class ClickEncoder
@@ -55,13 +65,42 @@ public:
 
   } Button;
 
+  // events pushed by service() into the ring buffer
+  typedef enum EventType_e {
+    EventRotate = 0,   // value is +1 or -1 notch
+    EventButton        // value is the new Button state
+  } EventType;
+
+  typedef struct Event_s {
+    unsigned long time;  // millis() when service() saw it
+    uint8_t type;        // EventType
+    int8_t value;
+    uint8_t accel;       // acceleration multiplier at the time of a rotation
+  } Event;
+
 public:
   ClickEncoder(uint8_t A, uint8_t B, uint8_t BTN = -1,
                uint8_t stepsPerNotch = 1, bool active = LOW);
 
   void service(void);
+  void service(uint64_t pins, unsigned long now);
+  static uint64_t readPins(void);
+
+#if ENC_EDGE_INTERRUPTS
+  // A/B change interrupts run on the core that calls this, at the same level as the timer interrupt
+  // so they never preempt ::service() and the event ring still has one producer at a time
+  void attachEdgeInterrupts(void);
+#endif
   int16_t getValue(void);
 
+  // the ring is single producer (service() in the timer ISR), single consumer (loop()) and needs no locking
+  // getValue() and getButton() are built on drain(). use either those or getEvent(), not both
+  bool getEvent(Event &ev);     // pop the oldest event, false if there are none
+  uint8_t drain(void);          // move all waiting events into the getValue()/getButton() state, returns how many
+
+  uint16_t getOverflows(void) const { return overflows; } // events lost because loop() didn't drain the ring in time
+  uint8_t getHighWater(void) const { return highWater; }  // most events ever waiting in the ring
+
 #ifndef WITHOUT_BUTTON
 public:
   Button getButton(void);
@@ -74,7 +113,7 @@ public:
     doubleClickEnabled = d;
   }
 
-  const bool getDoubleClickEnabled()
+  bool getDoubleClickEnabled()
   {
     return doubleClickEnabled;
   }
@@ -89,7 +128,7 @@ public:
     }
   }
 
-  const bool getAccelerationEnabled()
+  bool getAccelerationEnabled()
   {
     return accelerationEnabled;
   }
@@ -99,21 +138,37 @@ private:
   const uint8_t pinB;
   const uint8_t pinBTN;
   const bool pinsActive;
-  volatile int16_t delta;
-  volatile int16_t last;
+  uint8_t activeBits;      // xor mask that makes A/B read 1 when active
+  unsigned long lastService = 0;
+  static uint64_t usedPins; // pins readPins() has to read when it can't read the port registers
+  void pushEvent(uint8_t type, int8_t value, unsigned long now);
+  void decode(uint64_t pins, unsigned long now);
+#if ENC_EDGE_INTERRUPTS
+  static void edgeISR(void *arg);
+#endif
+
+  int16_t delta;           // raw steps not yet reported as a notch, ISR only
+  volatile uint8_t last;   // previous and current A/B pair
   uint8_t steps;
   volatile uint16_t acceleration;
   bool accelerationEnabled;
-#if ENC_DECODER != ENC_NORMAL
   static const int8_t table[16];
-#endif
 #ifndef WITHOUT_BUTTON
-  volatile Button button;
+  volatile Button button; // live button state seen by the ISR
   bool doubleClickEnabled;
   uint16_t keyDownTicks = 0;
   uint8_t doubleClickTicks = 0;
   unsigned long lastButtonCheck = 0;
+  Button buttons[8];       // button events drained from the ring, waiting for getButton()
+  uint8_t buttonCount = 0;
 #endif
+  Event events[ENC_EVENTS];
+  volatile uint8_t eventHead = 0;  // written by the ISR
+  volatile uint8_t eventTail = 0;  // written by loop()
+  volatile uint16_t overflows = 0;
+  volatile uint8_t highWater = 0;
+  int16_t notches = 0;     // drained rotation waiting for getValue()
+  uint8_t notchAccel = 0;  // acceleration at the last drained notch
 };
 
 // ----------------------------------------------------------------------------
@@ -0,0 +1,119 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+//
+// boot state - the parameter array and menu position are kept in NVS so the editor comes up where it was left without
+// waiting for the synth. the state is coded with snapshots.h and written a few seconds after the last change so editing
+// doesn't wear the flash. at boot the saved state is drawn right away and a dump from the synth is queued in the background -
+// boot_correct() then fixes only the parameters that don't match the synth
+
+#ifndef BOOTSTATE_H_
+#define BOOTSTATE_H_
+
+#define BOOT_KEY "boot"
+#define BOOT_VERSION 1
+#define BOOT_CHECK 1000       // ms between checks for a changed state
+#define BOOT_SAVE_DELAY 5000  // ms the state has to stay the same before it is written
+#define BOOT_MENUBYTES 64     // max size of the menu position
+#define BOOT_MAXLEN (2+BOOT_MENUBYTES+SNAP_MAXLEN)
+
+uint8_t bootsaved[BOOT_MAXLEN];  // the state in NVS
+uint16_t bootsavedlen;
+uint8_t bootlast[BOOT_MAXLEN];   // the state at the last check
+uint16_t bootlastlen;
+unsigned long bootchecktime;
+unsigned long bootchangetime;    // millis() when the state last changed
+uint8_t bootresync[SYNTH_PARAMS]; // the synth's parameters, dumped at boot
+
+// boot state statistics
+uint16_t bootsaves;             // times the state was written
+uint16_t bootcorrected;         // parameters the resync had to fix
+
+// the state is version, menu length, menu position, coded parameters
+uint16_t boot_encode(const uint8_t * menu, uint8_t menulen, uint8_t * out) {
+  out[0]=BOOT_VERSION;
+  out[1]=menulen;
+  memcpy(&out[2],menu,menulen);
+  return 2+menulen+snap_encode(parameters,&out[2+menulen]);
+}
+
+// restore the parameters and menu position from NVS
+// returns the length of the menu position, 0 if there is no usable state
+uint8_t boot_restore(uint8_t * menu) {
+  uint16_t len=nvs.getBytes(BOOT_KEY,bootsaved,BOOT_MAXLEN);
+  if ((len < 2) || (bootsaved[0] != BOOT_VERSION) || (bootsaved[1] > BOOT_MENUBYTES) || (len < 2+bootsaved[1])) return 0;
+  uint8_t menulen=bootsaved[1];
+  if (!snap_decode(&bootsaved[2+menulen],len-2-menulen,parameters)) return 0;
+  memcpy(menu,&bootsaved[2],menulen);
+  bootsavedlen=len;
+  return menulen;
+}
+
+// true once every BOOT_CHECK ms - time to call boot_check()
+bool boot_due(void) {
+  if ((millis() - bootchecktime) < BOOT_CHECK) return false;
+  bootchecktime=millis();
+  return true;
+}
+
+// write the state once it has stopped changing
+void boot_check(const uint8_t * menu, uint8_t menulen) {
+  static uint8_t state[BOOT_MAXLEN];
+  uint16_t len=boot_encode(menu,menulen,state);
+  if ((len != bootlastlen) || memcmp(state,bootlast,len)) {  // still changing
+    memcpy(bootlast,state,len);
+    bootlastlen=len;
+    bootchangetime=millis();
+    return;
+  }
+  if ((len == bootsavedlen) && !memcmp(state,bootsaved,len)) return;  // already saved
+  if ((millis() - bootchangetime) < BOOT_SAVE_DELAY) return;
+  if (nvs.putBytes(BOOT_KEY,state,len) != len) return;
+  memcpy(bootsaved,state,len);
+  bootsavedlen=len;
+  ++bootsaves;
+}
+
+// queue the background dump - done is called when it is in bootresync
+bool boot_resync(synthcallback done) {
+  return synth_queue(CMD_DUMP,0,0,bootresync,done);
+}
+
+// copy the parameters that differ from the synth's dump, except ones edited since boot that are still waiting to go out
+// returns how many were fixed
+uint16_t boot_correct(void) {
+  uint16_t n=0;
+  paramsknown=true;
+  for (uint16_t i=1; i < SYNTH_PARAMS; ++i) {  // param 0 isn't used
+    if ((parameters[i] == bootresync[i]) || writeq_has(i)) continue;
+    parameters[i]=bootresync[i];
+    ++n;
+  }
+  bootcorrected=n;
+  return n;
+}
+
+#endif // BOOTSTATE_H_
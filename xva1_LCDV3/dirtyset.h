@@ -0,0 +1,128 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+//
+// -----------------------------------------------------------------------------
+//
+// packed sets of synth parameters - one bit per parameter, 16 words for all 512
+// walking a set goes a word at a time and jumps straight to the next set bit with count trailing zeros, so an empty or
+// sparse set costs 16 word tests however many parameters there are
+// edited holds the parameters changed in the editor since the patch was loaded or saved, relative to editbase. it drives
+// the edited markers on the LCD. changed is those plus the ones changed on the synth itself, which are part of the patch
+// but not the user's edits - it drives the resend after the synth comes back from a reset, where the base patch is
+// recalled and only the changed parameters are uploaded on top of it. snapedited is both since the last snapshot save or load
+
+#ifndef DIRTYSET_H_
+#define DIRTYSET_H_
+
+#define PSET_PARAMS 512                // same as SYNTH_PARAMS
+#define PSET_WORDS (PSET_PARAMS/32)
+
+#define EDIT_NOBASE -1                 // editbase values other than a memory slot
+#define EDIT_INIT -2
+
+struct paramset {
+  uint32_t w[PSET_WORDS];
+};
+
+struct paramset edited;                // parameters edited since the patch was loaded or saved
+struct paramset changed;               // edited plus the ones changed on the synth - everything that differs from editbase
+struct paramset snapedited;            // since the last snapshot save or load
+int16_t editbase=EDIT_NOBASE;          // slot the edits are relative to, EDIT_INIT or EDIT_NOBASE if it isn't known
+int16_t snapclean=-1;                  // snapshot the parameters match while snapedited is empty, -1 if none
+bool paramsknown;                      // the parameter array holds a real patch - false at boot until the synth's is read or one is loaded
+
+void pset_set(struct paramset * s, uint16_t param) {
+  if (param < PSET_PARAMS) s->w[param >> 5]|=(uint32_t)1 << (param & 31);
+}
+
+void pset_clear(struct paramset * s, uint16_t param) {
+  if (param < PSET_PARAMS) s->w[param >> 5]&=~((uint32_t)1 << (param & 31));
+}
+
+bool pset_test(const struct paramset * s, uint16_t param) {
+  return (param < PSET_PARAMS) && (s->w[param >> 5] & ((uint32_t)1 << (param & 31)));
+}
+
+void pset_clearall(struct paramset * s) {
+  memset(s->w,0,sizeof(s->w));
+}
+
+bool pset_empty(const struct paramset * s) {
+  for (uint8_t i=0; i < PSET_WORDS; ++i) {
+    if (s->w[i]) return false;
+  }
+  return true;
+}
+
+uint16_t pset_count(const struct paramset * s) {
+  uint16_t n=0;
+  for (uint8_t i=0; i < PSET_WORDS; ++i) n+=__builtin_popcount(s->w[i]);
+  return n;
+}
+
+// first parameter in the set at or after from, PSET_PARAMS if there is none
+// for (uint16_t p=pset_next(s,0); p < PSET_PARAMS; p=pset_next(s,p+1)) visits them all
+uint16_t pset_next(const struct paramset * s, uint16_t from) {
+  if (from >= PSET_PARAMS) return PSET_PARAMS;
+  uint8_t i=from >> 5;
+  uint32_t bits=s->w[i] & ((uint32_t)0xFFFFFFFF << (from & 31));  // drop the ones before from
+  while (bits == 0) {
+    if (++i >= PSET_WORDS) return PSET_PARAMS;
+    bits=s->w[i];
+  }
+  return (i << 5)+__builtin_ctz(bits);
+}
+
+// a parameter was changed in the editor
+void edit_mark(uint16_t param) {
+  pset_set(&edited,param);
+  pset_set(&changed,param);
+  pset_set(&snapedited,param);
+}
+
+// a parameter was changed on the synth - it no longer matches the base patch but it isn't an edit
+void edit_synth(uint16_t param) {
+  pset_set(&changed,param);
+  pset_set(&snapedited,param);
+}
+
+// the parameter array now matches base - a slot, EDIT_INIT or EDIT_NOBASE - with no edits
+void edit_newbase(int16_t base) {
+  editbase=base;
+  paramsknown=true;
+  pset_clearall(&edited);
+  pset_clearall(&changed);
+  snapclean=-1;
+}
+
+// the parameter array matches snapshot n
+void edit_snapshot(int16_t n) {
+  snapclean=n;
+  pset_clearall(&snapedited);
+}
+
+#endif // DIRTYSET_H_
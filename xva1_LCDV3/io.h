@@ -30,14 +30,24 @@
 #ifndef IO_H_
 #define IO_H_
 
-// SPI pins
-//#define MISO 12
-//#define MOSI 11
-//#define SCLK 13
-
-
-// SD card chip select pin
-//#define SD_CS 15
+// SPI pins and chip select for the SD card patch library - only used when SDCARD is defined
+// my board has no free pins for the card: MOSI, SCLK and CS need outputs and 0 is the only free one left, 37 and 38 are input
+// only. the defaults below are where the card would go with the LCD moved off VSPI, so SDCARD won't build for this board as
+// wired - the check at the end of this file stops it until the pins don't clash. define them before this file to override
+#ifdef SDCARD
+#ifndef SD_MISO
+#define SD_MISO 38  // input only is fine for MISO
+#endif
+#ifndef SD_MOSI
+#define SD_MOSI 23  // VSPI MOSI - LCD_RS on my board
+#endif
+#ifndef SD_SCLK
+#define SD_SCLK 18  // VSPI SCLK - LCD_D6 on my board
+#endif
+#ifndef SD_CS
+#define SD_CS   0   // boot strap pin but the card's CS pullup keeps it high at reset
+#endif
+#endif
 
 // encoder pins
 #define ENC_A   5
@@ -59,9 +69,37 @@
 #define P4_SW   12
 
 
+// LCD pins - 4 bit mode
+#define LCD_RS  23
+#define LCD_E   33
+#define LCD_D4  25
+#define LCD_D5  15
+#define LCD_D6  18
+#define LCD_D7  19
+
 // potentiometer A/D input ports
 #define VOLUMEPOT 39
 
+// pots for the 4 parameter fields - only used when PARAMPOTS is defined
+// they have to be ADC1 pins (32-39) like the volume pot - ADC2 can't be read while the radio is on. 37 and 38 are the only
+// ones free on my board, the others are the P3/P4 encoders and the volume pot, so two encoder pins have to move to free up
+// P3POT and P4POT - the check at the end of this file stops the build until they don't clash. define them before this file
+// to override
+#ifdef PARAMPOTS
+#ifndef P1POT
+#define P1POT 37
+#endif
+#ifndef P2POT
+#define P2POT 38
+#endif
+#ifndef P3POT
+#define P3POT 34  // P3ENC_A on my board
+#endif
+#ifndef P4POT
+#define P4POT 35  // P3ENC_B on my board
+#endif
+#endif
+
 // MIDI serial port pins
 #define MIDIRX 27
 #define MIDITX 14
@@ -70,6 +108,52 @@
 #define RXD2 16
 #define TXD2 17
 
+// pin checks for the optional hardware - only on the esp32, the host build in host/ has no pins to clash
+// GPIOs 6-11 are the SPI flash and 20, 24, 28-31 don't exist
+#if defined(ARDUINO_ARCH_ESP32)
+#define IO_BADPIN(p) (((p) < 0) || (((p) >= 6) && ((p) <= 11)) || ((p) == 20) || ((p) == 24) || (((p) >= 28) && ((p) <= 31)) || ((p) > 39))
+#define IO_INPUTONLY(p) (((p) >= 34) && ((p) <= 39))
+#define IO_USED(p) (((p) == ENC_A) || ((p) == ENC_B) || ((p) == ENC_SW) \
+  || ((p) == P1ENC_A) || ((p) == P1ENC_B) || ((p) == P1_SW) || ((p) == P2ENC_A) || ((p) == P2ENC_B) || ((p) == P2_SW) \
+  || ((p) == P3ENC_A) || ((p) == P3ENC_B) || ((p) == P3_SW) || ((p) == P4ENC_A) || ((p) == P4ENC_B) || ((p) == P4_SW) \
+  || ((p) == LCD_RS) || ((p) == LCD_E) || ((p) == LCD_D4) || ((p) == LCD_D5) || ((p) == LCD_D6) || ((p) == LCD_D7) \
+  || ((p) == VOLUMEPOT) || ((p) == MIDIRX) || ((p) == MIDITX) || ((p) == RXD2) || ((p) == TXD2))
+
+#ifdef SDCARD
+#if IO_BADPIN(SD_MISO) || IO_BADPIN(SD_MOSI) || IO_BADPIN(SD_SCLK) || IO_BADPIN(SD_CS)
+#error "SD card pins have to be GPIOs that exist and aren't the flash pins 6-11"
+#endif
+#if IO_INPUTONLY(SD_MOSI) || IO_INPUTONLY(SD_SCLK) || IO_INPUTONLY(SD_CS)
+#error "SD card MOSI, SCLK and CS can't be on the input only pins 34-39"
+#endif
+#if IO_USED(SD_MISO) || IO_USED(SD_MOSI) || IO_USED(SD_SCLK) || IO_USED(SD_CS)
+#error "SD card pins clash with the encoders, LCD, volume pot or serial ports - move them in io.h"
+#endif
+#if (SD_MISO == SD_MOSI) || (SD_MISO == SD_SCLK) || (SD_MISO == SD_CS) || (SD_MOSI == SD_SCLK) || (SD_MOSI == SD_CS) || (SD_SCLK == SD_CS)
+#error "SD card pins have to be 4 different pins"
+#endif
+#endif
+
+#ifdef PARAMPOTS
+#define IO_ADC1(p) (((p) >= 32) && ((p) <= 39))
+#if !IO_ADC1(P1POT) || !IO_ADC1(P2POT) || !IO_ADC1(P3POT) || !IO_ADC1(P4POT)
+#error "parameter pots have to be on ADC1 pins 32-39"
+#endif
+#if IO_USED(P1POT) || IO_USED(P2POT) || IO_USED(P3POT) || IO_USED(P4POT)
+#error "parameter pots clash with the encoders, LCD, volume pot or serial ports - move them in io.h"
+#endif
+#if (P1POT == P2POT) || (P1POT == P3POT) || (P1POT == P4POT) || (P2POT == P3POT) || (P2POT == P4POT) || (P3POT == P4POT)
+#error "parameter pots have to be on 4 different pins"
+#endif
+#ifdef SDCARD
+#define IO_POT(p) (((p) == P1POT) || ((p) == P2POT) || ((p) == P3POT) || ((p) == P4POT))
+#if IO_POT(SD_MISO) || IO_POT(SD_MOSI) || IO_POT(SD_SCLK) || IO_POT(SD_CS)
+#error "SD card pins clash with the parameter pots"
+#endif
+#endif
+#endif
+#endif // ARDUINO_ARCH_ESP32
+
 
 
 
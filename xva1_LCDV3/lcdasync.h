@@ -0,0 +1,112 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// interrupt driven HD44780 output
+// LiquidCrystal::print() busy waits ~40us per character plus the enable pulses, all of it inside loop()
+// LCDAsync only queues 4 bit nibbles in a ring buffer. a hardware timer calls service() which puts one nibble on the
+// pins and strobes E, so the LCD fills in the background while loop() goes on with the encoders
+// LiquidCrystal is still used to initialize the controller in setup() - its init sequence needs long delays anyway
+
+#ifndef LCDASYNC_H_
+#define LCDASYNC_H_
+
+#define LCDQ_SIZE 256          // nibbles in the ring - 256 lets the uint8_t indexes wrap by themselves
+#define LCD_TIMER_MICROS 50    // one nibble per tick. a byte is 2 ticks = 100us, HD44780 needs 37us to execute it
+#define LCDQ_RS 0x10           // ring entry flag - nibble goes to the data register, otherwise the instruction register
+
+class LCDAsync
+{
+public:
+  LCDAsync(uint8_t rs, uint8_t enable, uint8_t d4, uint8_t d5, uint8_t d6, uint8_t d7)
+    : pinRS(rs), pinE(enable), head(0), tail(0)
+  {
+    pinD[0]=d4;
+    pinD[1]=d5;
+    pinD[2]=d6;
+    pinD[3]=d7;
+  }
+
+  // queue a DDRAM address command
+  void setCursor(uint8_t col, uint8_t row)
+  {
+    static const uint8_t rowoffsets[] = {0x00, 0x40, 0x14, 0x54}; // 20x4 line start addresses
+    push(0x80 | (col + rowoffsets[row & 3]), 0);
+  }
+
+  // queue a character
+  size_t write(uint8_t c)
+  {
+    push(c,LCDQ_RS);
+    return 1;
+  }
+
+  // number of bytes that can be queued without waiting
+  uint8_t room(void)
+  {
+    return (uint8_t)(LCDQ_SIZE - 1 - (uint8_t)(head - tail)) / 2;
+  }
+
+  // flush barrier - wait until everything queued is on the display
+  // the spin loops yield() so the host build gets to run the timer while we wait
+  void wait(void)
+  {
+    while (head != tail) yield();
+  }
+
+  // timer interrupt - send one nibble
+  void ICACHE_RAM_ATTR service(void)
+  {
+    if (tail == head) return;
+    uint8_t n=ring[tail];
+    digitalWrite(pinRS,(n & LCDQ_RS) ? HIGH : LOW);
+    for (uint8_t i=0; i < 4; ++i) digitalWrite(pinD[i],(n >> i) & 1);
+    digitalWrite(pinE,HIGH);  // enable pulse must be >450ns
+    delayMicroseconds(1);
+    digitalWrite(pinE,LOW);
+    ++tail;
+  }
+
+private:
+  // queue a byte as two nibbles, high nibble first
+  // the caller makes sure there is room - if there isn't we wait for the timer to make some
+  void push(uint8_t b, uint8_t rs)
+  {
+    while (room() == 0) yield();
+    ring[head]=(b >> 4) | rs;
+    ring[(uint8_t)(head+1)]=(b & 0x0f) | rs;
+    __asm__ __volatile__("" ::: "memory"); // ring entries must be written before the ISR can see the new head
+    head+=2;
+  }
+
+  const uint8_t pinRS;
+  const uint8_t pinE;
+  uint8_t pinD[4];
+  volatile uint8_t head;  // written by loop()
+  volatile uint8_t tail;  // written by the timer interrupt
+  uint8_t ring[LCDQ_SIZE];
+};
+
+#endif // LCDASYNC_H_
@@ -0,0 +1,122 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// shadow frame buffer for the 20x4 LCD
+// all drawing goes into a RAM copy of the display. update() compares it with what is on the glass and sends only the
+// characters that changed, so redrawing a whole line or menu costs nothing when most of it is the same
+// every HD44780 transfer is slow so update() also keeps track of the LCD cursor and only sends a set cursor command
+// when the next changed character isn't where the LCD will put it anyway
+// the bytes go to the interrupt driven LCDAsync queue. if the queue fills up update() stops and the characters it didn't get to
+// are still different from the screen copy, so they go out on the next update()
+
+#ifndef LCDBUFFER_H_
+#define LCDBUFFER_H_
+
+#include "lcdasync.h"
+
+class LCDBuffer : public Print
+{
+public:
+  LCDBuffer(LCDAsync &display) : lcd(display)
+  {
+    clear();
+    memset(screen,' ',sizeof(screen));  // LiquidCrystal::begin() clears the display before LCDAsync takes over
+    lcdx=lcdy=0xff;
+  }
+
+  // blank the frame buffer - the LCD changes on the next update()
+  void clear(void)
+  {
+    memset(shadow,' ',sizeof(shadow));
+    x=y=0;
+  }
+
+  void setCursor(uint8_t col, uint8_t row)
+  {
+    x=col;
+    y=row;
+  }
+
+  // Print calls this for every character. text past the end of a line is clipped, the LCD would wrap it to some other line
+  size_t write(uint8_t c)
+  {
+    if ((x >= LCD_X) || (y >= LCD_Y)) return 0;
+    shadow[y][x++]=c;
+    return 1;
+  }
+  using Print::write;
+
+  // send changed characters to the LCD - call once per pass of loop()
+  // returns the number of bytes sent. a cursor move counts as one byte, same as a character
+  uint16_t update(void)
+  {
+    uint16_t bytes=0;
+    for (uint8_t row=0; row < LCD_Y; ++row) {
+      for (uint8_t col=0; col < LCD_X; ++col) {
+        if (shadow[row][col] == screen[row][col]) continue;
+        if (lcd.room() < 3) { // worst case is a gap character, a cursor move and the character. finish next time
+          row=LCD_Y;
+          break;
+        }
+        if ((row == lcdy) && (col == lcdx+1)) { // one unchanged character in the way - resending it is as cheap as a cursor move
+          lcd.write(screen[row][lcdx]);
+          ++bytes;
+          ++lcdx;
+        }
+        if ((row != lcdy) || (col != lcdx)) {
+          lcd.setCursor(col,row);
+          ++bytes;
+        }
+        lcd.write(shadow[row][col]);
+        ++bytes;
+        screen[row][col]=shadow[row][col];
+        lcdx=col+1;
+        lcdy=row;
+        if (lcdx >= LCD_X) lcdx=lcdy=0xff;  // the LCD address counter jumps to another line at the end of a line
+      }
+    }
+    if (bytes) {
+      framebytes=bytes;
+      totalbytes+=bytes;
+      ++frames;
+    }
+    return bytes;
+  }
+
+  // LCD traffic statistics
+  uint16_t framebytes;  // bytes sent by the last update() that sent anything
+  uint32_t totalbytes;  // bytes sent since startup
+  uint32_t frames;      // number of updates that sent anything
+
+private:
+  LCDAsync &lcd;
+  char shadow[LCD_Y][LCD_X];  // what we want on the display
+  char screen[LCD_Y][LCD_X];  // what is on the display
+  uint8_t x,y;                // frame buffer cursor
+  uint8_t lcdx,lcdy;          // where the LCD will put the next character, 0xff if we don't know
+};
+
+#endif // LCDBUFFER_H_
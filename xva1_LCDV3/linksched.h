@@ -0,0 +1,134 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// bandwidth scheduler for the serial link to the XVA1
+// everything that goes out Serial2 belongs to a class. each class has a token bucket - a byte budget that refills at rate
+// bytes per ms up to depth bytes - and may only send what its bucket holds. the classes are in priority order: writeq_flush()
+// sends the waiting parameter writes of the highest class that has budget first, and the link engine holds back bulk work
+// (starting a transaction, streaming an upload) while an interactive class has a write waiting that it could send
+// the link runs at 50 bytes per ms. bulk is kept below that so interactive frames always find room in the UART FIFO,
+// and pots get a small budget so a noisy one can't flood the link
+
+#ifndef LINKSCHED_H_
+#define LINKSCHED_H_
+
+// classes, highest priority first
+enum linkclass {LC_EDIT, LC_REMOTE, LC_POT, LC_BULK, LC_COUNT};
+
+#define LINK_MAXFRAME 4   // longest 's' frame - 's' 255 address-256 value
+
+struct linkbudget {
+  uint16_t rate;      // bytes per ms
+  uint16_t depth;     // most bytes the bucket holds
+  int32_t tokens;     // budget in 1/1000 bytes - bulk charges whole commands so it can go negative
+  uint8_t waiting;    // writes queued in this class
+  // statistics
+  uint32_t frames;    // frames or transactions sent
+  uint32_t bytes;     // bytes sent
+  uint32_t held;      // checks that found the class out of budget - about one per loop() pass while it waits
+  uint32_t latency;   // total us from queue to send, for the average
+  uint32_t maxlatency;
+};
+
+const char * const linkclassnames[LC_COUNT] = {"edit", "remote", "pot", "bulk"};
+
+struct linkbudget linkbudgets[LC_COUNT] = {
+  // rate,depth, then the bucket and statistics which start empty
+  {30,60,0,0,0,0,0,0,0},  // encoder edits
+  {10,30,0,0,0,0,0,0,0},  // MIDI CC and NRPN
+  {1,8,0,0,0,0,0,0,0},    // pots - ~300 frames a second is plenty
+  {35,128,0,0,0,0,0,0,0}, // uploads, dumps and slot commands
+};
+unsigned long linkrefilltime;  // micros() of the last refill
+bool linkheld;                 // interactive writes are held back - see sched_hold()
+
+// top up the buckets - cheap enough to call every pass of loop() and from the link engine
+void sched_refill(void) {
+  unsigned long now=micros();
+  uint32_t elapsed=now-linkrefilltime;
+  if (elapsed == 0) return;
+  if (elapsed > 100000) elapsed=100000;  // a long stall doesn't buy a bigger burst than a full bucket anyway
+  linkrefilltime=now;
+  for (uint8_t c=0; c < LC_COUNT; ++c) {
+    struct linkbudget * b=&linkbudgets[c];
+    int32_t full=(int32_t)b->depth*1000;
+    b->tokens+=elapsed*b->rate;  // bytes per ms is 1/1000 bytes per us
+    if (b->tokens > full) b->tokens=full;
+  }
+}
+
+// true if the class can send bytes now
+bool sched_ready(uint8_t cls, uint8_t bytes) {
+  if (linkbudgets[cls].tokens >= (int32_t)bytes*1000) return true;
+  ++linkbudgets[cls].held;
+  return false;
+}
+
+// bytes went out for the class
+void sched_charge(uint8_t cls, uint8_t bytes) {
+  linkbudgets[cls].tokens-=(int32_t)bytes*1000;
+  linkbudgets[cls].bytes+=bytes;
+}
+
+// a frame or transaction of the class is done - latency is us since it was queued
+void sched_done(uint8_t cls, uint32_t latency) {
+  struct linkbudget * b=&linkbudgets[cls];
+  ++b->frames;
+  b->latency+=latency;
+  if (latency > b->maxlatency) b->maxlatency=latency;
+}
+
+// true if an interactive write is waiting and has the budget to go - bulk work holds off for it
+bool sched_interactive(void) {
+  if (linkheld) return false;
+  for (uint8_t c=0; c < LC_BULK; ++c) {
+    struct linkbudget * b=&linkbudgets[c];
+    if (b->waiting && (b->tokens >= LINK_MAXFRAME*1000)) return true;
+  }
+  return false;
+}
+
+// hold the interactive writes back while bulk work has the synth on another patch - reading a slot loads it, so a write
+// sent before the patch is put back would be lost. bulk work doesn't wait for them while they are held
+void sched_hold(bool hold) {
+  linkheld=hold;
+}
+
+// change a class's budget
+void sched_rate(uint8_t cls, uint16_t rate, uint16_t depth) {
+  linkbudgets[cls].rate=rate;
+  linkbudgets[cls].depth=depth;
+}
+
+void sched_report(Print & out) {
+  out.printf("class     frames    bytes     held  avg us  max us\n");
+  for (uint8_t c=0; c < LC_COUNT; ++c) {
+    struct linkbudget * b=&linkbudgets[c];
+    out.printf("%-7s %8u %8u %8u %7u %7u\n",linkclassnames[c],b->frames,b->bytes,b->held,b->frames ? b->latency/b->frames : 0,b->maxlatency);
+  }
+}
+
+#endif // LINKSCHED_H_
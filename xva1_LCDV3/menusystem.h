@@ -38,7 +38,18 @@
 #define LOAD_SLOT 512  // parameter numbers I use for XVA1 memory load and save slots
 #define WRITE_SLOT 513
 #define INIT_SLOT 514  // fake parameter for init menu
-#define DUMMY 515   // dummy - editing this one does no harm 
+#define MIDI_LEARN 515 // CC learn on/off
+#define LIB_BANK 516   // SD card library bank and patch number being browsed
+#define LIB_NUM 517
+#define LIB_LOAD 518   // fake parameters for the library double clicks
+#define LIB_SAVE 519
+#define SNAP_NUM 520   // NVS snapshot number and fake parameters for its double clicks
+#define SNAP_LOAD 521
+#define SNAP_SAVE 522
+#define SNAP_COUNT 32   // see snapshots.h
+#define LIB_BANKS 40    // library holds LIB_BANKS*LIB_PERBANK patches - see sdlibrary.h
+#define LIB_PERBANK 100
+#define DUMMY 523   // dummy - editing this one does no harm 
 #define NUMPARAMS DUMMY+1
 
 enum paramtype{TYPE_NONE,TYPE_NUM, TYPE_TEXT}; // parameter display types
@@ -49,25 +60,27 @@ unsigned char controls[4]={0,2,12,15};
 
 // submenus 
 struct submenu {
-  char *name; // display short name
-  char *longname; // longer name displays on message line
+  const char *name; // display short name
+  const char *longname; // longer name displays on message line
   uint8_t range;  // max value of parameter
   enum paramtype ptype; // how its displayed
-  char ** ptext;   // points to array of text for text display
+  const char * const * ptext;   // points to array of text for text display
   uint16_t parameter; // parameter number
 };
 
 // the parameter arrays must be padded to a multiple of SUBMENU_FIELDS ie 4, 8, 12 etc
 // this makes the index wrap around checking a lot easier. 
 // makes sense to scroll submenus SUBMENU_FIELDS at a time. if we side scroll one at a time the parameter positions change which could be a bit confusing
+// all the menu tables are constexpr so they stay in flash, and the static_asserts after the top menus check the padding,
+// the parameter numbers and that every text table has an entry for each value of its parameter
 
 
 
 // oscillator submenus
-char * textoffon[] = {" OFF", "  ON"};
-char * textwaves[] = {"SAWU", "SAWD"," SQR"," TRI"," SIN","NOIS","SS3S","SS7M","SS7S"};
+constexpr const char * textoffon[] = {" OFF", "  ON"};
+constexpr const char * textwaves[] = {"SAWU", "SAWD"," SQR"," TRI"," SIN","NOIS","SS3S","SS7M","SS7S"};
 
-struct submenu osc1params[] = {
+constexpr struct submenu osc1params[] = {
   // name,longname,range,type,textfield,parameter#
   "ENAB","Osc. On/Off",1,TYPE_TEXT,textoffon,1,
   "WAVE","Waveform",8,TYPE_TEXT,textwaves,11,
@@ -78,9 +91,12 @@ struct submenu osc1params[] = {
   "LVLL","Level Left",255,TYPE_NUM,0,31, 
   "LVLR","Level Right",255,TYPE_NUM,0,32,
   "SDET","Sawstack Detune",255,TYPE_NUM,0,285, 
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
 };
 
-struct submenu osc2params[] = {
+constexpr struct submenu osc2params[] = {
   // name,longname,range,type,textfield,parameter#
   "ENAB","Osc. On/Off",1,TYPE_TEXT,textoffon,2,
   "WAVE","Waveform",8,TYPE_TEXT,textwaves,12,
@@ -91,9 +107,12 @@ struct submenu osc2params[] = {
   "LVLL","Level Left",255,TYPE_NUM,0,33, 
   "LVLR","Level Right",255,TYPE_NUM,0,34,
   "SDET","Sawstack Detune",255,TYPE_NUM,0,286,
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
 };
 
-struct submenu osc3params[] = {
+constexpr struct submenu osc3params[] = {
   // name,longname,range,type,textfield,parameter#
   "ENAB","Osc. On/Off",1,TYPE_TEXT,textoffon,3,
   "WAVE","Waveform",8,TYPE_TEXT,textwaves,13,
@@ -105,9 +124,11 @@ struct submenu osc3params[] = {
   "LVLR","Level Right",255,TYPE_NUM,0,36,
   "SDET","Sawstack Detune",255,TYPE_NUM,0,287,
   "RING","Ringmod 3-4",1,TYPE_TEXT,textoffon,271,
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
 };
 
-struct submenu osc4params[] = {
+constexpr struct submenu osc4params[] = {
   // name,longname,range,type,textfield,parameter#
   "ENAB","Osc. On/Off",1,TYPE_TEXT,textoffon,4,
   "WAVE","Waveform",8,TYPE_TEXT,textwaves,14,
@@ -118,14 +139,17 @@ struct submenu osc4params[] = {
   "LVLL","Level Left",255,TYPE_NUM,0,37, 
   "LVLR","Level Right",255,TYPE_NUM,0,38,
   "SDET","Sawstack Detune",255,TYPE_NUM,0,288,
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
 };
 
 // filter parameter submenus
-char * textfilter[] = {" BYP","LP1P","LP2P","LP3P","LP4P","HP1P","HP2P","HP3P","HP4P","BP2P","BP4P","BP2P","BR4P","LLPS","LBPS",
+constexpr const char * textfilter[] = {" BYP","LP1P","LP2P","LP3P","LP4P","HP1P","HP2P","HP3P","HP4P","BP2P","BP4P","BP2P","BR4P","LLPS","LBPS",
     "LHPS","LLPP","LBPP","LHPP","BBPP","BHPP","HHPP"};
-char * textfiltroute[] = {" STD","  LR"};
+constexpr const char * textfiltroute[] = {" STD","  LR"};
 
-struct submenu filtparams[] = {
+constexpr struct submenu filtparams[] = {
   // name,longname,range,display type,textfield *,parameter number
   "TYPE","Filter Type",21,TYPE_TEXT,textfilter,71,  // filter type
   "CUT1","Filter 1 Cut",255,TYPE_NUM,0,72,  // cutoff 1 freq
@@ -143,11 +167,14 @@ struct submenu filtparams[] = {
   " KBR","Keyboard Resonance",255,TYPE_NUM,0,277,   // keyboard resonance
 
   "ROUT","Filter Routing",1,TYPE_TEXT,textfiltroute,278,   // routing
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
 };
 
 
 // save patch menu - uses internal parameter WRITE_SLOT
-struct submenu saveparams[] = {
+constexpr struct submenu saveparams[] = {
 // name,range,display type,textfield *,parameter number
   "Slot","Double Click to Save",127,TYPE_NUM,0,WRITE_SLOT,   // XVA1 memory slots 0-127 
   "    ","Save to Memory",0,TYPE_NONE,0,DUMMY,     
@@ -156,7 +183,7 @@ struct submenu saveparams[] = {
 };
 
 // load patch menu - uses internal parameter LOAD_SLOT
-struct submenu loadparams[] = {
+constexpr struct submenu loadparams[] = {
 // name,longname,range,display type,textfield *,parameter number
   "Slot","Load from Memory",127,TYPE_NUM,0,LOAD_SLOT,   // XVA1 memory slots 0-127
   "    ","",1,TYPE_NONE,0,DUMMY,     
@@ -165,8 +192,8 @@ struct submenu loadparams[] = {
 };
 
 // init patch menu - uses dummy internal parameter INIT_SLOT
-char * textinit[] = {"Clik",};
-struct submenu initparams[] = {
+constexpr const char * textinit[] = {"Clik",};
+constexpr struct submenu initparams[] = {
 // name,longname,range,display type,textfield *,parameter number
   "Dubl","Double Click to Init",0,TYPE_TEXT,textinit,INIT_SLOT,   // INIT_SLOT used to interpret the double click  
   "    ","",1,TYPE_NONE,0,DUMMY,   // dummy parameter doesn't display
@@ -176,7 +203,7 @@ struct submenu initparams[] = {
 
 // envelope generator submenus
 // just doing ADSR to keep it simple
-struct submenu egampparams[] = {
+constexpr struct submenu egampparams[] = {
   // name,longname,range,display type,textfield *,parameter number
   "ARAT","Attack Rate",255,TYPE_NUM,0,117,  // attack rate
   "DRAT","Decay Rate",255,TYPE_NUM,0,127,  // decay1 rate
@@ -184,7 +211,7 @@ struct submenu egampparams[] = {
   "RRAT","Release Rate",255,TYPE_NUM,0,132,   // release rate 
 };
 
-struct submenu egfiltparams[] = {
+constexpr struct submenu egfiltparams[] = {
   // name,longname,range,display type,textfield *,parameter number
   "ARAT","Attack Rate",255,TYPE_NUM,0,116,  // attack rate
   "DRAT","Decay Rate",255,TYPE_NUM,0,126,  // decay1 rate
@@ -192,7 +219,7 @@ struct submenu egfiltparams[] = {
   "RRAT","Release Rate",255,TYPE_NUM,0,131,   // release rate 
 };
 
-struct submenu egpitchparams[] = {
+constexpr struct submenu egpitchparams[] = {
   // name,longname,range,display type,textfield *,parameter number
   "ARAT","Attack Rate",255,TYPE_NUM,0,115,  // attack rate
   "DRAT","Decay Rate",255,TYPE_NUM,0,125,  // decay1 rate
@@ -201,10 +228,10 @@ struct submenu egpitchparams[] = {
 };
 
 // LFO submenus
-char * textlfowaves[] = {" TRI"," SQR","SAWU","SAWD"," SIN","Sx2x","Sx3x","Sx^3","GUIT"," S&H"};
-char * textlforange[] = {" LOW","HIGH"};
-char * textlfosync[] = {"FREE"," KEY","MFRE","MKEY"};
-struct submenu lfo1params[] = {
+constexpr const char * textlfowaves[] = {" TRI"," SQR","SAWU","SAWD"," SIN","Sx2x","Sx3x","Sx^3","GUIT"," S&H"};
+constexpr const char * textlforange[] = {" LOW","HIGH"};
+constexpr const char * textlfosync[] = {"FREE"," KEY","MFRE","MKEY"};
+constexpr struct submenu lfo1params[] = {
   // name,longname,range,display type,textfield *,parameter number
   "WAVE","Waveform",9,TYPE_TEXT,textlfowaves,160,  // waveform
   "RANG","Range",1,TYPE_TEXT,textlforange,166,  // range
@@ -220,7 +247,7 @@ struct submenu lfo1params[] = {
   "AAFT","Aftertouch Amp.",255,TYPE_NUM,0,192,  // aftertouch amp
 };
 
-struct submenu lfo2params[] = {
+constexpr struct submenu lfo2params[] = {
   // name,longname,range,display type,textfield *,parameter number
   "WAVE","Waveform",9,TYPE_TEXT,textlfowaves,170,  // waveform
   "RANG","Range",1,TYPE_TEXT,textlforange,176,  // range
@@ -237,9 +264,9 @@ struct submenu lfo2params[] = {
 };
 
 // Reverb submenus
-char * textrvbmode[] = {"PLAT","HALL"};
+constexpr const char * textrvbmode[] = {"PLAT","HALL"};
 
-struct submenu reverbparams[] = {
+constexpr struct submenu reverbparams[] = {
   // name,longname,range,display type,textfield *,parameter number
   " WET","Reverb Level",255,TYPE_NUM,0,391,  // wet level
   "MODE","Reverb Type",1,TYPE_TEXT,textrvbmode,392,  // reverb type
@@ -248,27 +275,29 @@ struct submenu reverbparams[] = {
   " HPF","Tail L.F. Cut",255,TYPE_NUM,0,397,  // hipass
   " SPD","Tail Mod Speed",255,TYPE_NUM,0,395,  // mod speed
   "DPTH","Tail Mod Level",255,TYPE_NUM,0,396,  // mod depth  
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
 };
 
 // Chorus submenus
-char * textchorusmode[] = {"MONO","STER","CROS"};
+constexpr const char * textstereomode[] = {"MONO","STER","CROS"};  // chorus and phaser
 
-struct submenu chorusparams[] = {
+constexpr struct submenu chorusparams[] = {
   // name,longname,range,display type,textfield *,parameter number
   " WET","Chorus Level",255,TYPE_NUM,0,361,  // wet level
-  "MODE","Chorus Type",2,TYPE_TEXT,textchorusmode,362,  //  type
+  "MODE","Chorus Type",2,TYPE_TEXT,textstereomode,362,  //  type
   " SPD","Speed",255,TYPE_NUM,0,363,  // mod speed
   "DPTH","Depth",255,TYPE_NUM,0,364,  // mod depth 
   "FDBK","Feedback",255,TYPE_NUM,0,365,  // 
   "LRPH","L-R Phase",255,TYPE_NUM,0,366,  // 
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
 };
 
 // phaser submenus
-char * textphasermode[] = {"MONO","STER","CROS"};
-struct submenu phaserparams[] = {
+constexpr struct submenu phaserparams[] = {
   // name,longname,range,display type,textfield *,parameter number
   " WET","Phaser Level",255,TYPE_NUM,0,311,  // wet level
-  "MODE","Phaser Type",2,TYPE_TEXT,textchorusmode,312,  //  type
+  "MODE","Phaser Type",2,TYPE_TEXT,textstereomode,312,  //  type
   " SPD","Speed",255,TYPE_NUM,0,314,  // mod speed
   "DPTH","Depth",255,TYPE_NUM,0,313,  // mod depth 
   "FDBK","Feedback",255,TYPE_NUM,0,315,  // 
@@ -280,7 +309,7 @@ struct submenu phaserparams[] = {
 
 // amp mod submenus
 
-struct submenu ampmodparams[] = {
+constexpr struct submenu ampmodparams[] = {
   // name,longname,range,display type,textfield *,parameter number
   " WET","Amp. Mod. Level",255,TYPE_NUM,0,330,  // wet level
   " SPD","Speed",255,TYPE_NUM,0,331,  // mod speed
@@ -289,9 +318,9 @@ struct submenu ampmodparams[] = {
 };
 
 // Delay submenus
-char * textdelaymode[] = {"STER","CROS"," LRC"," RLC","MONO",};
+constexpr const char * textdelaymode[] = {"STER","CROS"," LRC"," RLC","MONO",};
 
-struct submenu delayparams[] = {
+constexpr struct submenu delayparams[] = {
   // name,longname,range,display type,textfield *,parameter number
   " WET","Delay Level",255,TYPE_NUM,0,301,  // wet level
   "MODE","Delay Type",4,TYPE_TEXT,textdelaymode,302,  
@@ -306,12 +335,15 @@ struct submenu delayparams[] = {
   "DPTH","Mod Depth",255,TYPE_NUM,0,299,  // mod depth 
   "SMER","Smear",7,TYPE_NUM,0,291,  
   "  2x","2X mode",1,TYPE_TEXT,textoffon,292,     
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
 };
 
 // global submenus
-char * textlegatomode[] = {"POLY","MONO",};
-char * textportamode[] =  {" OFF","  ON","FING",};
-struct submenu globalparams[] = {
+constexpr const char * textlegatomode[] = {"POLY","MONO",};
+constexpr const char * textportamode[] = {" OFF","  ON","FING",};
+constexpr struct submenu globalparams[] = {
   // name,longname,range,display type,textfield *,parameter number
   "TPOS","Transpose",255,TYPE_NUM,0,241,  
   "BNDU","Bend Up Range",10,TYPE_NUM,0,242,  
@@ -323,11 +355,13 @@ struct submenu globalparams[] = {
   " PAN","Pan",255,TYPE_NUM,0,247,  
   "VOFF","Velocity Offset",127,TYPE_NUM,0,249,  // 
   "TUNE","Tuning",255,TYPE_NUM,0,251,  
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
 };
 
 // gate submenus
 
-struct submenu gateparams[] = {
+constexpr struct submenu gateparams[] = {
   // name,longname,range,display type,textfield *,parameter number
   "ENAB","Gate Enable",1,TYPE_TEXT,textoffon,385,   
   "CURV","Curve Shape",1,TYPE_NUM,0,386,  // mod speed
@@ -336,8 +370,8 @@ struct submenu gateparams[] = {
 };
 
 // arp submenus
-char * textarpmode[] = {" OFF","  UP","DOWN","UPDN","PLAY","RAND"};
-struct submenu arpparams[] = {
+constexpr const char * textarpmode[] = {" OFF","  UP","DOWN","UPDN","PLAY","RAND"};
+constexpr struct submenu arpparams[] = {
   // name,longname,range,display type,textfield *,parameter number
   "MODE","Arp Mode",5,TYPE_TEXT,textarpmode,450,   
   "TMPO","Tempo (min 44)",255,TYPE_NUM,0,451,  
@@ -348,7 +382,7 @@ struct submenu arpparams[] = {
 // sequencer submenus
 //char * textseqsteps[] = {"   1","   2","   3","   4","   5","   6","   7","   8","   9",
 //    "  10","  11","  12","  13","  14","  15","  16",};  // maps 0-16 to 1-16
-struct submenu seqparams[] = {
+constexpr struct submenu seqparams[] = {
   // name,longname,range,display type,textfield *,parameter number
   "ENAB","On/Off",1,TYPE_TEXT,textoffon,428,  
   "VELO","Velocity",127,TYPE_NUM,0,429,  
@@ -377,7 +411,7 @@ struct submenu seqparams[] = {
 };
 
 // MIDI submenus
-struct submenu midiparams[] = {
+constexpr struct submenu midiparams[] = {
   // name,longname,range,display type,textfield *,parameter number
   "PAFT","Pitch Aftertouch",255,TYPE_NUM,0,200,   
   "PRND","Pitch Random",255,TYPE_NUM,0,203, 
@@ -395,14 +429,18 @@ struct submenu midiparams[] = {
   "CL3H","Control 3 LO",255,TYPE_NUM,0,405, 
   "CL4L","Control 4 HI",255,TYPE_NUM,0,406,  
   "CL4H","Control 4 LO",255,TYPE_NUM,0,407, 
+  "LERN","MIDI CC Learn",1,TYPE_TEXT,textoffon,MIDI_LEARN,  // next CC controls the last edited parameter
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
 };
 
 // Effects submenus - groups together stuff that I don't use much on 2nd menu
-char * textgain[] = {" 0dB","+6dB","12dB","18dB",};
-char * textdtype[] = {"CLIP","SOFT","TUB1","TUB2",};
-char * textdfilt[] = {"48kc","20kc","18kc","16kc","14kc","12kc","10kc"," 8kHz",};
+constexpr const char * textgain[] = {" 0dB","+6dB","12dB","18dB",};
+constexpr const char * textdtype[] = {"CLIP","SOFT","TUB1","TUB2",};
+constexpr const char * textdfilt[] = {"48kc","20kc","18kc","16kc","14kc","12kc","10kc"," 8kHz",};
 
-struct submenu fxparams[] = {
+constexpr struct submenu fxparams[] = {
   // name,longname,range,display type,textfield *,parameter number
   " PRE","Pre FX Gain",3,TYPE_TEXT,textgain,510,   
   "POST","Post FX Gain",3,TYPE_TEXT,textgain,511, 
@@ -415,10 +453,11 @@ struct submenu fxparams[] = {
   "FILT","Post Dist. Filter",7,TYPE_TEXT,textdfilt,353,  
   "CRSH","Bitcrusher Depth",24,TYPE_NUM,0,380,  
   "DECI","Decimator Depth",23,TYPE_NUM,0,370,  
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
 };
 
 // performance parameters - quick access to useful parameters
-struct submenu perfparams[] = {
+constexpr struct submenu perfparams[] = {
   // name,longname,range,type,textfield,parameter#
   " CUT","Filter Cutoff",255,TYPE_NUM,0,72,
   "DPTH","Filter E.G. Depth",255,TYPE_NUM,0,75,
@@ -434,13 +473,38 @@ struct submenu perfparams[] = {
   "PHAS","Phaser Level",255,TYPE_NUM,0,311,
   "  AM","Amp Mod Level",255,TYPE_NUM,0,330,
   " SEQ","Sequencer On/Off",1,TYPE_TEXT,textoffon,428,  
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
+  "    ","",1,TYPE_NONE,0,DUMMY,   // padding
 };
 
+// patch snapshots in flash - uses internal parameters SNAP_NUM etc
+constexpr struct submenu snapshotparams[] = {
+// name,longname,range,display type,textfield *,parameter number
+  "SNAP","Snapshot",SNAP_COUNT-1,TYPE_NUM,0,SNAP_NUM,
+  "    ","",1,TYPE_NONE,0,DUMMY,   // dummy parameter doesn't display
+  "LOAD","Double Click to Load",0,TYPE_TEXT,textinit,SNAP_LOAD,
+  "SAVE","Double Click to Save",0,TYPE_TEXT,textinit,SNAP_SAVE,
+};
+
+#ifdef SDCARD
+// SD card patch library - uses internal parameters LIB_BANK etc
+constexpr struct submenu libraryparams[] = {
+// name,longname,range,display type,textfield *,parameter number
+  "BANK","Library Bank",LIB_BANKS-1,TYPE_NUM,0,LIB_BANK,
+  " NUM","Library Patch",LIB_PERBANK-1,TYPE_NUM,0,LIB_NUM,
+  "LOAD","Double Click to Load",0,TYPE_TEXT,textinit,LIB_LOAD,
+  "SAVE","Double Click to Save",0,TYPE_TEXT,textinit,LIB_SAVE,
+};
+#endif
+
+// a lookup entry for every synth parameter, generated from tools/xva1params.csv by tools/genparams.py
+// after the text tables above, which it uses for the labels they already have
+#include "paramtable.h"
+
 // top menus
 struct menu {
-   char *name; // menu text
-   struct submenu * submenus; // points to submenus for this menu
-   int8_t submenuindex;   // stores the index of the submenu we are currently using
+   const char *name; // menu text
+   const struct submenu * submenus; // points to submenus for this menu
    int8_t numsubmenus; // number of submenus - not sure why this has to be int but it crashes otherwise. compiler bug?
 };
 
@@ -452,42 +516,175 @@ struct menu {
 #define LFOS 4
 #define EFFECTS 9
 
-struct menu mainmenu[] = {
-  // name,submenu *,initial submenu index,number of submenus
-
-  "Oscillator 1",osc1params,0,sizeof(osc1params)/sizeof(submenu),
-  "Oscillator 2",osc2params,0,sizeof(osc2params)/sizeof(submenu),
-  "Oscillator 3",osc3params,0,sizeof(osc3params)/sizeof(submenu),
-  "Oscillator 4",osc4params,0,sizeof(osc4params)/sizeof(submenu),
-  "LFO 1",lfo1params,0,sizeof(lfo1params)/sizeof(submenu),
-  "LFO 2",lfo2params,0,sizeof(lfo2params)/sizeof(submenu),
-  "Filters",filtparams,0,sizeof(filtparams)/sizeof(submenu),
-  "Amplitude Envelope",egampparams,0,sizeof(egampparams)/sizeof(submenu),
-  "Filter Envelope",egfiltparams,0,sizeof(egfiltparams)/sizeof(submenu),
-  "Reverb",reverbparams,0,sizeof(reverbparams)/sizeof(submenu),
-  "Delay",delayparams,0,sizeof(delayparams)/sizeof(submenu),
-  "Chorus/Flanger",chorusparams,0,sizeof(chorusparams)/sizeof(submenu),
-  "Phaser",phaserparams,0,sizeof(phaserparams)/sizeof(submenu),
-  "Init Patch(Dub Clik)",initparams,0,sizeof(initparams)/sizeof(submenu),
-  "Save Patch(Dub Clik)",saveparams,0,sizeof(saveparams)/sizeof(submenu),
-  "Load Patch",loadparams,0,sizeof(loadparams)/sizeof(submenu),
-};
-
-#define NUM_MAIN_MENUS sizeof(mainmenu)/ sizeof(menu)
+constexpr struct menu mainmenu[] = {
+  // name,submenu *,number of submenus
+
+  "Oscillator 1",osc1params,sizeof(osc1params)/sizeof(submenu),
+  "Oscillator 2",osc2params,sizeof(osc2params)/sizeof(submenu),
+  "Oscillator 3",osc3params,sizeof(osc3params)/sizeof(submenu),
+  "Oscillator 4",osc4params,sizeof(osc4params)/sizeof(submenu),
+  "LFO 1",lfo1params,sizeof(lfo1params)/sizeof(submenu),
+  "LFO 2",lfo2params,sizeof(lfo2params)/sizeof(submenu),
+  "Filters",filtparams,sizeof(filtparams)/sizeof(submenu),
+  "Amplitude Envelope",egampparams,sizeof(egampparams)/sizeof(submenu),
+  "Filter Envelope",egfiltparams,sizeof(egfiltparams)/sizeof(submenu),
+  "Reverb",reverbparams,sizeof(reverbparams)/sizeof(submenu),
+  "Delay",delayparams,sizeof(delayparams)/sizeof(submenu),
+  "Chorus/Flanger",chorusparams,sizeof(chorusparams)/sizeof(submenu),
+  "Phaser",phaserparams,sizeof(phaserparams)/sizeof(submenu),
+  "Init Patch(Dub Clik)",initparams,sizeof(initparams)/sizeof(submenu),
+  "Save Patch(Dub Clik)",saveparams,sizeof(saveparams)/sizeof(submenu),
+  "Load Patch",loadparams,sizeof(loadparams)/sizeof(submenu),
+};
+
+#define NUM_MAIN_MENUS (sizeof(mainmenu)/ sizeof(menu))
 
 // second menu for less used parameters
 
-struct menu secondarymenu[] = {
-  // name,submenu *,initial submenu index,number of submenus
-  "* Performance ",perfparams,0,sizeof(perfparams)/sizeof(submenu),
-  "* Global Params",globalparams,0,sizeof(globalparams)/sizeof(submenu),
-  "* Amplitude Modulator",ampmodparams,0,sizeof(ampmodparams)/sizeof(submenu),
-  "* Arpeggiator",arpparams,0,sizeof(arpparams)/sizeof(submenu),
-  "* Sequencer",seqparams,0,sizeof(seqparams)/sizeof(submenu),
-  "* Gate",gateparams,0,sizeof(gateparams)/sizeof(submenu),
-  "* Pitch Envelope",egpitchparams,0,sizeof(egpitchparams)/sizeof(submenu),
-  "* Additional Effects",fxparams,0,sizeof(fxparams)/sizeof(submenu),
-  "* MIDI",midiparams,0,sizeof(midiparams)/sizeof(submenu),
+constexpr struct menu secondarymenu[] = {
+  // name,submenu *,number of submenus
+  "* Performance ",perfparams,sizeof(perfparams)/sizeof(submenu),
+  "* Global Params",globalparams,sizeof(globalparams)/sizeof(submenu),
+  "* Amplitude Modulator",ampmodparams,sizeof(ampmodparams)/sizeof(submenu),
+  "* Arpeggiator",arpparams,sizeof(arpparams)/sizeof(submenu),
+  "* Sequencer",seqparams,sizeof(seqparams)/sizeof(submenu),
+  "* Gate",gateparams,sizeof(gateparams)/sizeof(submenu),
+  "* Pitch Envelope",egpitchparams,sizeof(egpitchparams)/sizeof(submenu),
+  "* Additional Effects",fxparams,sizeof(fxparams)/sizeof(submenu),
+  "* MIDI",midiparams,sizeof(midiparams)/sizeof(submenu),
+  "* Snapshots",snapshotparams,sizeof(snapshotparams)/sizeof(submenu),
+#ifdef SDCARD
+  "* SD Library",libraryparams,sizeof(libraryparams)/sizeof(submenu),
+#endif
+};
+
+#define NUM_SECONDARY_MENUS (sizeof(secondarymenu)/ sizeof(menu))
+#define NUM_MENUS (NUM_MAIN_MENUS+NUM_SECONDARY_MENUS)
+
+// submenu index each top menu is scrolled to - the only part of the menus that changes so it lives in RAM
+int8_t mainsubmenuindex[NUM_MAIN_MENUS];
+int8_t secondarysubmenuindex[NUM_SECONDARY_MENUS];
+int8_t * submenuindex=mainsubmenuindex;  // goes with topmenu
+
+// compile time checks of the menu tables
+// every text table has to be listed here so its size is known - a TYPE_TEXT parameter using one that isn't fails to compile
+struct texttable {
+  const char * const * text;
+  uint8_t count;
+};
+
+#define TEXTTABLE(t) {t,sizeof(t)/sizeof(t[0])}
+constexpr struct texttable texttables[] = {
+  TEXTTABLE(textoffon),TEXTTABLE(textwaves),TEXTTABLE(textfilter),TEXTTABLE(textfiltroute),TEXTTABLE(textinit),
+  TEXTTABLE(textlfowaves),TEXTTABLE(textlforange),TEXTTABLE(textlfosync),TEXTTABLE(textrvbmode),TEXTTABLE(textstereomode),
+  TEXTTABLE(textdelaymode),TEXTTABLE(textlegatomode),TEXTTABLE(textportamode),TEXTTABLE(textarpmode),TEXTTABLE(textgain),
+  TEXTTABLE(textdtype),TEXTTABLE(textdfilt),
+  PARAMTABLE_TEXTTABLES  // the labels paramtable.h adds
 };
 
-#define NUM_SECONDARY_MENUS sizeof(secondarymenu)/ sizeof(menu)
+// number of entries in a text table, 0 if it isn't listed
+constexpr uint8_t textcount(const char * const * text, uint8_t i=0) {
+  return (i >= sizeof(texttables)/sizeof(texttables[0])) ? 0 : (texttables[i].text == text) ? texttables[i].count : textcount(text,i+1);
+}
+
+constexpr bool submenuok(const struct submenu & s) {
+  return (s.parameter < NUMPARAMS) && ((s.ptype != TYPE_TEXT) || (textcount(s.ptext) > s.range));
+}
+
+constexpr bool submenusok(const struct submenu * s, int8_t n, int8_t i=0) {
+  return (i >= n) || (submenuok(s[i]) && submenusok(s,n,i+1));
+}
+
+constexpr bool menusok(const struct menu * m, uint8_t n, uint8_t i=0) {
+  return (i >= n) || (((m[i].numsubmenus % SUBMENU_FIELDS) == 0) && submenusok(m[i].submenus,m[i].numsubmenus) && menusok(m,n,i+1));
+}
+
+static_assert(menusok(mainmenu,NUM_MAIN_MENUS),"main menu tables - padding, parameter number or text table size");
+static_assert(menusok(secondarymenu,NUM_SECONDARY_MENUS),"secondary menu tables - padding, parameter number or text table size");
+
+// reverse index - where each parameter is on the menus, built at compile time so finding one is a table lookup
+// menu counts the main menus first then the secondary ones. the Performance menu repeats parameters from the other menus
+// so each parameter has room for two places, menu -1 for ones it doesn't have
+struct menuplace {
+  int8_t menu;
+  int8_t index;
+};
+
+struct paramplace {
+  int8_t menu;    // first menu the parameter is on
+  int8_t index;
+  int8_t menu2;   // a later one it is on too
+  int8_t index2;
+};
+
+constexpr const struct menu & anymenu(uint8_t m) {
+  return (m < NUM_MAIN_MENUS) ? mainmenu[m] : secondarymenu[m-NUM_MAIN_MENUS];
+}
+
+constexpr int8_t findsubmenu(const struct submenu * s, int8_t n, uint16_t p, int8_t i=0) {
+  return (i >= n) ? -1 : (s[i].parameter == p) ? i : findsubmenu(s,n,p,i+1);
+}
+
+constexpr struct menuplace placeat(uint8_t m, int8_t index) {
+  return {(int8_t)((index < 0) ? -1 : m),index};
+}
+
+// first place of p on menu m or after
+constexpr struct menuplace findparam(uint16_t p, uint8_t m=0) {
+  return ((p == DUMMY) || (m >= NUM_MENUS)) ? placeat(0,-1) :
+    (findsubmenu(anymenu(m).submenus,anymenu(m).numsubmenus,p) >= 0) ? placeat(m,findsubmenu(anymenu(m).submenus,anymenu(m).numsubmenus,p)) :
+    findparam(p,m+1);
+}
+
+// the place of p after place a
+constexpr struct menuplace nextplace(uint16_t p, struct menuplace a) {
+  return (a.index < 0) ? a : findparam(p,a.menu+1);
+}
+
+constexpr struct paramplace twoplaces(struct menuplace a, struct menuplace b) {
+  return {a.menu,a.index,b.menu,b.index};
+}
+
+constexpr struct paramplace findplaces(uint16_t p) {
+  return twoplaces(findparam(p),nextplace(p,findparam(p)));
+}
+
+// no parameter is on more than two menus - checked in halves so the recursion stays shallow
+constexpr bool placesok(uint16_t first, uint16_t end) {
+  return (end-first == 1) ? (nextplace(first,nextplace(first,findparam(first))).index < 0) :
+    (placesok(first,(first+end)/2) && placesok((first+end)/2,end));
+}
+
+static_assert(placesok(0,NUMPARAMS),"a parameter is on more than two menus - the reverse index only has room for two");
+
+// C++11 has no index_sequence so here is one - built by doubling so the template depth stays small
+template <unsigned... I> struct paramindices {
+  typedef paramindices<I...,(sizeof...(I)+I)...> doubled;
+  typedef paramindices<I...,(sizeof...(I)+I)...,2*sizeof...(I)> doubledplusone;
+};
+
+template <unsigned N> struct makeparamindices;
+template <bool odd, class half> struct growparamindices {typedef typename half::doubled type;};
+template <class half> struct growparamindices<true,half> {typedef typename half::doubledplusone type;};
+template <unsigned N> struct makeparamindices {
+  typedef typename growparamindices<N % 2,typename makeparamindices<N/2>::type>::type type;
+};
+template <> struct makeparamindices<0> {typedef paramindices<> type;};
+
+template <class indices> struct paramindex;
+template <unsigned... P> struct paramindex<paramindices<P...> > {
+  static constexpr struct paramplace places[sizeof...(P)]={findplaces(P)...};
+};
+template <unsigned... P> constexpr struct paramplace paramindex<paramindices<P...> >::places[sizeof...(P)];
+
+typedef paramindex<makeparamindices<NUMPARAMS>::type> paramplaces;
+
+// where parameter p is on the menus
+const struct paramplace & paramlocation(uint16_t p) {
+  return paramplaces::places[p];
+}
+
+// the generated table entry of synth parameter p - every one 0-511 has one, TYPE_NONE with range 255 if it isn't described
+const struct submenu & paraminfo(uint16_t p) {
+  return paramtable[p];
+}
@@ -0,0 +1,193 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// MIDI input byte stream parser
+// handles running status, realtime messages in the middle of other messages, system common messages and SysEx framing
+// midi_parse() is fed every byte that is waiting on the MIDI port and turns them into typed events in a small queue
+// that loop() empties with midi_getevent() after each byte. a byte finishes at most one event so the queue never holds
+// more than one - it is kept as a queue so the parser doesn't care when loop() looks, with a little room to spare.
+// SysEx data goes into one buffer so parsing pauses after each complete SysEx message until it has been handled
+
+#ifndef MIDIPARSER_H_
+#define MIDIPARSER_H_
+
+#define MIDIQ_SIZE 4      // events waiting for loop(), must be a power of 2 - see above
+#define SYSEX_MAX 128     // longest SysEx message we keep, longer ones are dropped
+
+// status values in midievent - channel messages have the channel stripped off
+#define MIDI_NOTEOFF      0x80
+#define MIDI_NOTEON       0x90
+#define MIDI_POLYPRESSURE 0xA0
+#define MIDI_CC           0xB0
+#define MIDI_PROGRAM      0xC0
+#define MIDI_CHANPRESSURE 0xD0
+#define MIDI_PITCHBEND    0xE0
+#define MIDI_SYSEX        0xF0  // data is in sysexbuf, sysexlen bytes not counting F0 and F7
+#define MIDI_SONGPOS      0xF2
+#define MIDI_CLOCK        0xF8
+#define MIDI_START        0xFA
+#define MIDI_CONTINUE     0xFB
+#define MIDI_STOP         0xFC
+#define MIDI_SENSING      0xFE
+
+struct midievent {
+  uint8_t status;   // one of the above
+  uint8_t channel;  // 1-16 for channel messages, 0 otherwise
+  uint8_t data1;
+  uint8_t data2;
+};
+
+struct midievent midiqueue[MIDIQ_SIZE];
+uint8_t midiqhead, midiqtail;
+
+uint8_t sysexbuf[SYSEX_MAX];
+uint16_t sysexlen;
+bool insysex;
+
+uint8_t runningstatus;  // current status byte, 0 if none
+uint8_t midineeded;     // data bytes the current status takes
+uint8_t midicount;      // data bytes received so far
+uint8_t mididata[2];
+
+// parser statistics
+uint32_t midibytes;        // bytes parsed since startup
+uint32_t midimessages;     // events produced since startup
+uint16_t midioverflows;    // events lost because the queue was full
+uint16_t midisysexdropped; // SysEx messages that were too long or cut off
+uint16_t midistray;        // data bytes with no status to go with them
+uint16_t midibyterate;     // bytes per second over the last second
+uint16_t midimsgrate;      // events per second over the last second
+uint32_t midiratebytes, midiratemsgs;  // totals at the start of the current second
+unsigned long midiratetime;
+
+// queue an event
+void midi_post(uint8_t status, uint8_t channel, uint8_t d1, uint8_t d2) {
+  if ((uint8_t)(midiqhead - midiqtail) >= MIDIQ_SIZE) {
+    ++midioverflows;
+    return;
+  }
+  struct midievent * e=&midiqueue[midiqhead & (MIDIQ_SIZE-1)];
+  e->status=status;
+  e->channel=channel;
+  e->data1=d1;
+  e->data2=d2;
+  ++midiqhead;
+  ++midimessages;
+}
+
+// get the oldest event, returns false if there are none
+bool midi_getevent(struct midievent &e) {
+  if (midiqhead == midiqtail) return false;
+  e=midiqueue[midiqtail & (MIDIQ_SIZE-1)];
+  ++midiqtail;
+  return true;
+}
+
+// number of data bytes that go with a system common status
+uint8_t midi_syscommonlength(uint8_t status) {
+  switch (status) {
+    case 0xF1:   // MTC quarter frame
+    case 0xF3:   // song select
+      return 1;
+    case MIDI_SONGPOS:
+      return 2;
+    default:     // tune request and undefined
+      return 0;
+  }
+}
+
+// parse one byte
+// returns true when a SysEx message is complete - the caller should stop feeding bytes until the event has been handled
+bool midi_parse(uint8_t b) {
+  ++midibytes;
+  if (b >= 0xF8) {  // realtime - can show up anywhere, even in the middle of another message, and doesn't change anything
+    midi_post(b,0,0,0);
+    return false;
+  }
+  if (b & 0x80) {   // status byte
+    if (insysex) {
+      insysex=false;
+      if (b == 0xF7) {  // normal end of SysEx
+        if (sysexlen <= SYSEX_MAX) {
+          midi_post(MIDI_SYSEX,0,0,0);
+          return true;
+        }
+        ++midisysexdropped;  // too long
+        return false;
+      }
+      ++midisysexdropped;  // any other status byte cuts a SysEx message off
+    }
+    midicount=0;
+    if (b == 0xF0) {
+      insysex=true;
+      sysexlen=0;
+      runningstatus=0;
+    }
+    else if (b >= 0xF0) {  // system common clears running status
+      runningstatus=0;
+      midineeded=midi_syscommonlength(b);
+      if (midineeded == 0) midi_post(b,0,0,0);
+      else runningstatus=b;  // just to collect its data bytes, cleared again below
+    }
+    else {
+      runningstatus=b;
+      midineeded=((b & 0xF0) == MIDI_PROGRAM || (b & 0xF0) == MIDI_CHANPRESSURE) ? 1 : 2;
+    }
+    return false;
+  }
+  // data byte
+  if (insysex) {
+    if (sysexlen < SYSEX_MAX) sysexbuf[sysexlen]=b;
+    if (sysexlen <= SYSEX_MAX) ++sysexlen;  // stops one past the end so we know it was too long
+    return false;
+  }
+  if (runningstatus == 0) {
+    ++midistray;
+    return false;
+  }
+  mididata[midicount++]=b;
+  if (midicount < midineeded) return false;
+  midicount=0;
+  if (midineeded == 1) mididata[1]=0;
+  if (runningstatus >= 0xF0) {
+    midi_post(runningstatus,0,mididata[0],mididata[1]);
+    runningstatus=0;
+  }
+  else midi_post(runningstatus & 0xF0,(runningstatus & 0x0F)+1,mididata[0],mididata[1]);  // running status stays for the next message
+  return false;
+}
+
+// update the rate statistics - call this every pass of loop()
+void midi_rates(void) {
+  if ((millis() - midiratetime) < 1000) return;
+  midiratetime=millis();
+  midibyterate=midibytes-midiratebytes;
+  midimsgrate=midimessages-midiratemsgs;
+  midiratebytes=midibytes;
+  midiratemsgs=midimessages;
+}
+
+#endif // MIDIPARSER_H_
@@ -0,0 +1,121 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// MIDI remote control of synth parameters
+// lets a DAW drive the XVA1 thru the editor's MIDI input on MIDI_Channel
+// NRPN 0-511 (CC 99/98 select, CC 6/38 data entry) writes any synth parameter directly - the 14 bit data value is
+// scaled down to 8 bits so CC 6 alone gives 0-254 in steps of 2 and CC 38 fills in the low bit
+// CC FIELD_CC to FIELD_CC+3 control the 4 parameters on screen like the parameter encoders, scaled to their range
+// any other CC can be learned: turn on LERN in the MIDI menu, edit a parameter with an encoder, then move the controller
+// values go thru the write queue so a fast automation lane gets merged down to one frame per flush and
+// can't swamp the serial link. values that don't change anything are dropped before they get that far
+
+#ifndef MIDIREMOTE_H_
+#define MIDIREMOTE_H_
+
+#define FIELD_CC 20          // CC 20-23 control the on screen parameters
+#define NRPN_NONE 0xffff     // no NRPN selected
+
+uint16_t ccmap[128];         // learned CCs - parameter number for each CC, 0 if not learned (parameter 0 isn't used by the synth)
+uint8_t ccrange[128];        // range of the learned parameter
+uint16_t nrpnparam=NRPN_NONE; // selected NRPN
+uint8_t nrpnmsb, nrpnlsb;
+uint8_t datamsb;             // last data entry MSB, CC 38 combines with it
+
+uint16_t lastedited;         // last synth parameter edited with an encoder - what CC learn binds to
+uint8_t lasteditedrange;
+
+// results for the UI - loop() shows these at a limited rate
+uint16_t remoteparam;        // last parameter changed from MIDI
+bool remotechanged;          // remoteparam changed since the UI last looked
+int16_t remotelearned=-1;    // CC that was just learned, -1 if none
+
+// statistics
+uint32_t remotewrites;       // values that changed a parameter
+uint32_t remotededup;        // values dropped because the parameter already had that value
+
+// scale a 7 bit controller value to 0-range
+uint8_t remote_scale(uint8_t val, uint8_t range) {
+  return ((uint16_t)val*range+63)/127;
+}
+
+// set a synth parameter from MIDI
+void remote_set(uint16_t param, uint8_t val) {
+  if ((param == 0) || (param >= LOAD_SLOT)) return; // internal parameters aren't remote controlled
+  if (val > paraminfo(param).range) val=paraminfo(param).range;  // NRPN can address anything - keep it inside the parameter's range
+  if (parameters[param] == val) {
+    ++remotededup;
+    return;
+  }
+  parameters[param]=val;
+  edit_mark(param);
+  writeq_put(param,val,LC_REMOTE);
+  ++remotewrites;
+  remoteparam=param;
+  remotechanged=true;
+}
+
+// handle a control change
+// page points at the first submenu on screen, fields is how many of the 4 fields are in use
+void remote_cc(uint8_t cc, uint8_t val, const struct submenu * page, int8_t fields) {
+  switch (cc) {
+    case 99:  // NRPN select
+      nrpnmsb=val;
+      nrpnparam=((uint16_t)nrpnmsb << 7) | nrpnlsb;
+      return;
+    case 98:
+      nrpnlsb=val;
+      nrpnparam=((uint16_t)nrpnmsb << 7) | nrpnlsb;
+      return;
+    case 101:  // RPN select - not ours, deselect the NRPN so its data entry doesn't land on a parameter
+    case 100:
+      nrpnparam=NRPN_NONE;
+      return;
+    case 6:    // data entry MSB
+      datamsb=val;
+      if (nrpnparam < SYNTH_PARAMS) remote_set(nrpnparam,val << 1);
+      return;
+    case 38:   // data entry LSB
+      if (nrpnparam < SYNTH_PARAMS) remote_set(nrpnparam,(datamsb << 1) | (val >> 6));
+      return;
+  }
+  if (parameters[MIDI_LEARN] && lastedited) {  // learn mode - bind this CC to the last edited parameter
+    ccmap[cc]=lastedited;
+    ccrange[cc]=lasteditedrange;
+    parameters[MIDI_LEARN]=0;
+    remotelearned=cc;
+  }
+  if (ccmap[cc]) {
+    remote_set(ccmap[cc],remote_scale(val,ccrange[cc]));
+    return;
+  }
+  if ((cc >= FIELD_CC) && (cc < FIELD_CC+SUBMENU_FIELDS) && (cc-FIELD_CC < fields)) {
+    const struct submenu * sub=&page[cc-FIELD_CC];
+    if (sub->ptype != TYPE_NONE) remote_set(sub->parameter,remote_scale(val,sub->range));
+  }
+}
+
+#endif // MIDIREMOTE_H_
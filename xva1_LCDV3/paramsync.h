@@ -0,0 +1,116 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+//
+// -----------------------------------------------------------------------------
+//
+// background parameter sync - follows changes made on the synth itself by its MIDI input, the sequencer or another editor
+// the XVA1 has no command to read back one parameter, so every SYNC_INTERVAL ms while the link and the editor are quiet a
+// 'd' dump is queued into syncimage and sync_correct() copies the parameters that differ into the parameter array, like
+// boot_correct() does at boot. they become part of the patch rather than edits - no edited marker, and the synth's value is
+// kept as it is even when the menus show a smaller range. a dump is 512 bytes, ~10ms of the link at 500kbaud, and goes thru the bulk budget in
+// linksched.h. it only starts after SYNC_IDLE ms without a local write so it doesn't hold up editing
+// a dump is thrown away if anything else was queued for the synth while it ran - a patch load or upload changes the whole array
+// the first good dump after any link failure isn't copied - the synth may have been reset. sync_restore() puts the editor's
+// patch back instead: the base patch is recalled and only the changed parameters are sent on top (see dirtyset.h). if the
+// editor never had a patch - the synth didn't answer at boot - the dump is copied like any other
+
+#ifndef PARAMSYNC_H_
+#define PARAMSYNC_H_
+
+#define SYNC_INTERVAL 1000    // ms between dumps, 0 turns background sync off
+#define SYNC_IDLE 300         // ms without a local write before a dump can start
+#define SYNC_BACKOFF 3000     // ms to wait after a dump failed - the synth is probably off
+
+uint8_t syncimage[SYNTH_PARAMS];      // the last dump
+struct paramset syncchanged;          // parameters the last sync_correct() changed
+unsigned long synctime;               // millis() when the last dump finished
+bool syncfailed;                      // the last dump didn't come back
+uint16_t syncfailures;                // synthfailures at the last good dump
+
+// sync statistics
+uint32_t syncdumps;                   // dumps compared
+uint32_t syncdiscarded;               // dumps thrown away
+uint32_t synccorrected;               // parameters changed by dumps
+uint16_t syncrestores;                // times the patch was put back after the link failed
+
+// true when a dump can be queued - the link is idle and nothing has been written for a while
+bool sync_due(void) {
+  if (SYNC_INTERVAL == 0) return false;
+  if ((millis() - synctime) < (syncfailed ? SYNC_BACKOFF : SYNC_INTERVAL)) return false;
+  return !synth_busy() && (writeqcount == 0) && ((millis() - writeqputtime) >= SYNC_IDLE);
+}
+
+// queue the dump - done is called when it is in syncimage
+bool sync_start(synthcallback done) {
+  return synth_queue(CMD_DUMP,0,0,syncimage,done);
+}
+
+// the dump finished - record when so the next one is SYNC_INTERVAL later
+// returns true if it is the first good dump since the link failed
+bool sync_finished(uint8_t result) {
+  synctime=millis();
+  syncfailed=(result != SYNTH_OK);
+  if (syncfailed) return false;
+  bool back=(synthfailures != syncfailures);
+  syncfailures=synthfailures;
+  return back;
+}
+
+// put the editor's patch back on the synth - recall the base patch and upload what changed, or all of it if there is no base
+// returns false if the editor has no patch to put back - the synth was never read at boot and nothing has been loaded
+bool sync_restore(synthcallback done) {
+  if (!paramsknown) return false;
+  ++syncrestores;
+  if (editbase >= 0) synth_queue(CMD_RECALL,editbase,0,0,NULL);
+  if (editbase == EDIT_INIT) synth_queue(CMD_INIT,0,0,NULL,NULL);
+  return synth_queue(CMD_UPLOAD,(editbase == EDIT_NOBASE) ? UPLOAD_ALL : UPLOAD_EDITED,0,parameters,done);
+}
+
+// copy the parameters that differ from the dump, except ones written since it started that are still waiting to go out
+// returns how many were changed, syncchanged holds which
+uint16_t sync_correct(void) {
+  pset_clearall(&syncchanged);
+  if (synth_busy()) {  // something was queued behind the dump - it may be about to replace the patch
+    ++syncdiscarded;
+    return 0;
+  }
+  ++syncdumps;
+  paramsknown=true;
+  uint16_t n=0;
+  for (uint16_t i=1; i < SYNTH_PARAMS; ++i) {  // param 0 isn't used
+    uint8_t val=syncimage[i];
+    if ((parameters[i] == val) || writeq_has(i)) continue;
+    parameters[i]=val;
+    edit_synth(i);  // the synth's patch differs from the base now too
+    pset_set(&syncchanged,i);
+    ++n;
+  }
+  synccorrected+=n;
+  return n;
+}
+
+#endif // PARAMSYNC_H_
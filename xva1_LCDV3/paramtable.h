@@ -0,0 +1,530 @@
+// generated by tools/genparams.py from tools/xva1params.csv - edit the CSV and run the script again, don't edit this file
+//
+// paramtable[p] describes synth parameter p for lookups by number. 189 parameters are described, the other 322 are
+// TYPE_NONE with range 255
+
+#ifndef PARAMTABLE_H_
+#define PARAMTABLE_H_
+
+#define PARAMTABLE_SIZE 512
+
+// for menusystem.h's list of text tables
+#define PARAMTABLE_TEXTTABLES
+
+constexpr struct submenu paramtable[] = {
+// name,longname,range,display type,textfield *,parameter number
+  "    ","",1,TYPE_NONE,0,DUMMY,   // 0 is not used by the synth
+  "ENAB","Osc. On/Off",1,TYPE_TEXT,textoffon,1,   // Oscillator 1
+  "ENAB","Osc. On/Off",1,TYPE_TEXT,textoffon,2,   // Oscillator 2
+  "ENAB","Osc. On/Off",1,TYPE_TEXT,textoffon,3,   // Oscillator 3
+  "ENAB","Osc. On/Off",1,TYPE_TEXT,textoffon,4,   // Oscillator 4
+  "    ","Parameter 5",255,TYPE_NONE,0,5,   // not described
+  "    ","Parameter 6",255,TYPE_NONE,0,6,   // not described
+  "    ","Parameter 7",255,TYPE_NONE,0,7,   // not described
+  "    ","Parameter 8",255,TYPE_NONE,0,8,   // not described
+  "    ","Parameter 9",255,TYPE_NONE,0,9,   // not described
+  "    ","Parameter 10",255,TYPE_NONE,0,10,   // not described
+  "WAVE","Waveform",8,TYPE_TEXT,textwaves,11,   // Oscillator 1
+  "WAVE","Waveform",8,TYPE_TEXT,textwaves,12,   // Oscillator 2
+  "WAVE","Waveform",8,TYPE_TEXT,textwaves,13,   // Oscillator 3
+  "WAVE","Waveform",8,TYPE_TEXT,textwaves,14,   // Oscillator 4
+  "  PW","Pulse Width",255,TYPE_NUM,0,15,   // Oscillator 1
+  "  PW","Pulse Width",255,TYPE_NUM,0,16,   // Oscillator 2
+  "  PW","Pulse Width",255,TYPE_NUM,0,17,   // Oscillator 3
+  "  PW","Pulse Width",255,TYPE_NUM,0,18,   // Oscillator 4
+  "TPOS","Transpose",255,TYPE_NUM,0,19,   // Oscillator 1
+  "TPOS","Transpose",255,TYPE_NUM,0,20,   // Oscillator 2
+  "TPOS","Transpose",255,TYPE_NUM,0,21,   // Oscillator 3
+  "TPOS","Transpose",255,TYPE_NUM,0,22,   // Oscillator 4
+  "DTUN","Detune",255,TYPE_NUM,0,23,   // Oscillator 1
+  "DTUN","Detune",255,TYPE_NUM,0,24,   // Oscillator 2
+  "DTUN","Detune",255,TYPE_NUM,0,25,   // Oscillator 3
+  "DTUN","Detune",255,TYPE_NUM,0,26,   // Oscillator 4
+  "LEVL","Level",255,TYPE_NUM,0,27,   // Oscillator 1
+  "LEVL","Level",255,TYPE_NUM,0,28,   // Oscillator 2
+  "LEVL","Level",255,TYPE_NUM,0,29,   // Oscillator 3
+  "LEVL","Level",255,TYPE_NUM,0,30,   // Oscillator 4
+  "LVLL","Level Left",255,TYPE_NUM,0,31,   // Oscillator 1
+  "LVLR","Level Right",255,TYPE_NUM,0,32,   // Oscillator 1
+  "LVLL","Level Left",255,TYPE_NUM,0,33,   // Oscillator 2
+  "LVLR","Level Right",255,TYPE_NUM,0,34,   // Oscillator 2
+  "LVLL","Level Left",255,TYPE_NUM,0,35,   // Oscillator 3
+  "LVLR","Level Right",255,TYPE_NUM,0,36,   // Oscillator 3
+  "LVLL","Level Left",255,TYPE_NUM,0,37,   // Oscillator 4
+  "LVLR","Level Right",255,TYPE_NUM,0,38,   // Oscillator 4
+  "    ","Parameter 39",255,TYPE_NONE,0,39,   // not described
+  "    ","Parameter 40",255,TYPE_NONE,0,40,   // not described
+  "    ","Parameter 41",255,TYPE_NONE,0,41,   // not described
+  "    ","Parameter 42",255,TYPE_NONE,0,42,   // not described
+  "    ","Parameter 43",255,TYPE_NONE,0,43,   // not described
+  "    ","Parameter 44",255,TYPE_NONE,0,44,   // not described
+  "    ","Parameter 45",255,TYPE_NONE,0,45,   // not described
+  "    ","Parameter 46",255,TYPE_NONE,0,46,   // not described
+  "    ","Parameter 47",255,TYPE_NONE,0,47,   // not described
+  "    ","Parameter 48",255,TYPE_NONE,0,48,   // not described
+  "    ","Parameter 49",255,TYPE_NONE,0,49,   // not described
+  "    ","Parameter 50",255,TYPE_NONE,0,50,   // not described
+  "    ","Parameter 51",255,TYPE_NONE,0,51,   // not described
+  "    ","Parameter 52",255,TYPE_NONE,0,52,   // not described
+  "    ","Parameter 53",255,TYPE_NONE,0,53,   // not described
+  "    ","Parameter 54",255,TYPE_NONE,0,54,   // not described
+  "    ","Parameter 55",255,TYPE_NONE,0,55,   // not described
+  "    ","Parameter 56",255,TYPE_NONE,0,56,   // not described
+  "    ","Parameter 57",255,TYPE_NONE,0,57,   // not described
+  "    ","Parameter 58",255,TYPE_NONE,0,58,   // not described
+  "    ","Parameter 59",255,TYPE_NONE,0,59,   // not described
+  "    ","Parameter 60",255,TYPE_NONE,0,60,   // not described
+  "    ","Parameter 61",255,TYPE_NONE,0,61,   // not described
+  "    ","Parameter 62",255,TYPE_NONE,0,62,   // not described
+  "    ","Parameter 63",255,TYPE_NONE,0,63,   // not described
+  "    ","Parameter 64",255,TYPE_NONE,0,64,   // not described
+  "    ","Parameter 65",255,TYPE_NONE,0,65,   // not described
+  "    ","Parameter 66",255,TYPE_NONE,0,66,   // not described
+  "    ","Parameter 67",255,TYPE_NONE,0,67,   // not described
+  "    ","Parameter 68",255,TYPE_NONE,0,68,   // not described
+  "    ","Parameter 69",255,TYPE_NONE,0,69,   // not described
+  "    ","Parameter 70",255,TYPE_NONE,0,70,   // not described
+  "TYPE","Filter Type",21,TYPE_TEXT,textfilter,71,   // Filters
+  "CUT1","Filter 1 Cut",255,TYPE_NUM,0,72,   // Filters
+  "VELO","Velocity Level",255,TYPE_NUM,0,73,   // Filters
+  "KBTR","Keyboard Tracking",255,TYPE_NUM,0,74,   // Filters
+  "  EG","Env. Gen. Level",255,TYPE_NUM,0,75,   // Filters
+  "EGVL","Env. Gen. Velocity",255,TYPE_NUM,0,76,   // Filters
+  "RES1","Filter 1 Resonance",255,TYPE_NUM,0,77,   // Filters
+  "CUT2","Filter 2 Cut",255,TYPE_NUM,0,78,   // Filters
+  "RES2","Filter 2 Resonance",255,TYPE_NUM,0,79,   // Filters
+  "    ","Parameter 80",255,TYPE_NONE,0,80,   // not described
+  "    ","Parameter 81",255,TYPE_NONE,0,81,   // not described
+  "    ","Parameter 82",255,TYPE_NONE,0,82,   // not described
+  "    ","Parameter 83",255,TYPE_NONE,0,83,   // not described
+  "    ","Parameter 84",255,TYPE_NONE,0,84,   // not described
+  "    ","Parameter 85",255,TYPE_NONE,0,85,   // not described
+  "    ","Parameter 86",255,TYPE_NONE,0,86,   // not described
+  "    ","Parameter 87",255,TYPE_NONE,0,87,   // not described
+  "    ","Parameter 88",255,TYPE_NONE,0,88,   // not described
+  "    ","Parameter 89",255,TYPE_NONE,0,89,   // not described
+  "    ","Parameter 90",255,TYPE_NONE,0,90,   // not described
+  "    ","Parameter 91",255,TYPE_NONE,0,91,   // not described
+  "    ","Parameter 92",255,TYPE_NONE,0,92,   // not described
+  "    ","Parameter 93",255,TYPE_NONE,0,93,   // not described
+  "    ","Parameter 94",255,TYPE_NONE,0,94,   // not described
+  "SUST","Sustain Level",255,TYPE_NUM,0,95,   // Pitch Envelope
+  "SUST","Sustain Level",255,TYPE_NUM,0,96,   // Filter Envelope
+  "SUST","Sustain Level",255,TYPE_NUM,0,97,   // Amplitude Envelope
+  "    ","Parameter 98",255,TYPE_NONE,0,98,   // not described
+  "    ","Parameter 99",255,TYPE_NONE,0,99,   // not described
+  "    ","Parameter 100",255,TYPE_NONE,0,100,   // not described
+  "    ","Parameter 101",255,TYPE_NONE,0,101,   // not described
+  "    ","Parameter 102",255,TYPE_NONE,0,102,   // not described
+  "    ","Parameter 103",255,TYPE_NONE,0,103,   // not described
+  "    ","Parameter 104",255,TYPE_NONE,0,104,   // not described
+  "    ","Parameter 105",255,TYPE_NONE,0,105,   // not described
+  "    ","Parameter 106",255,TYPE_NONE,0,106,   // not described
+  "    ","Parameter 107",255,TYPE_NONE,0,107,   // not described
+  "    ","Parameter 108",255,TYPE_NONE,0,108,   // not described
+  "    ","Parameter 109",255,TYPE_NONE,0,109,   // not described
+  "    ","Parameter 110",255,TYPE_NONE,0,110,   // not described
+  "    ","Parameter 111",255,TYPE_NONE,0,111,   // not described
+  "    ","Parameter 112",255,TYPE_NONE,0,112,   // not described
+  "    ","Parameter 113",255,TYPE_NONE,0,113,   // not described
+  "    ","Parameter 114",255,TYPE_NONE,0,114,   // not described
+  "ARAT","Attack Rate",255,TYPE_NUM,0,115,   // Pitch Envelope
+  "ARAT","Attack Rate",255,TYPE_NUM,0,116,   // Filter Envelope
+  "ARAT","Attack Rate",255,TYPE_NUM,0,117,   // Amplitude Envelope
+  "    ","Parameter 118",255,TYPE_NONE,0,118,   // not described
+  "    ","Parameter 119",255,TYPE_NONE,0,119,   // not described
+  "    ","Parameter 120",255,TYPE_NONE,0,120,   // not described
+  "    ","Parameter 121",255,TYPE_NONE,0,121,   // not described
+  "    ","Parameter 122",255,TYPE_NONE,0,122,   // not described
+  "    ","Parameter 123",255,TYPE_NONE,0,123,   // not described
+  "    ","Parameter 124",255,TYPE_NONE,0,124,   // not described
+  "DRAT","Decay Rate",255,TYPE_NUM,0,125,   // Pitch Envelope
+  "DRAT","Decay Rate",255,TYPE_NUM,0,126,   // Filter Envelope
+  "DRAT","Decay Rate",255,TYPE_NUM,0,127,   // Amplitude Envelope
+  "    ","Parameter 128",255,TYPE_NONE,0,128,   // not described
+  "    ","Parameter 129",255,TYPE_NONE,0,129,   // not described
+  "RRAT","Release Rate",255,TYPE_NUM,0,130,   // Pitch Envelope
+  "RRAT","Release Rate",255,TYPE_NUM,0,131,   // Filter Envelope
+  "RRAT","Release Rate",255,TYPE_NUM,0,132,   // Amplitude Envelope
+  "    ","Parameter 133",255,TYPE_NONE,0,133,   // not described
+  "    ","Parameter 134",255,TYPE_NONE,0,134,   // not described
+  "    ","Parameter 135",255,TYPE_NONE,0,135,   // not described
+  "    ","Parameter 136",255,TYPE_NONE,0,136,   // not described
+  "    ","Parameter 137",255,TYPE_NONE,0,137,   // not described
+  "    ","Parameter 138",255,TYPE_NONE,0,138,   // not described
+  "    ","Parameter 139",255,TYPE_NONE,0,139,   // not described
+  "    ","Parameter 140",255,TYPE_NONE,0,140,   // not described
+  "    ","Parameter 141",255,TYPE_NONE,0,141,   // not described
+  "    ","Parameter 142",255,TYPE_NONE,0,142,   // not described
+  "    ","Parameter 143",255,TYPE_NONE,0,143,   // not described
+  "    ","Parameter 144",255,TYPE_NONE,0,144,   // not described
+  "    ","Parameter 145",255,TYPE_NONE,0,145,   // not described
+  "    ","Parameter 146",255,TYPE_NONE,0,146,   // not described
+  "    ","Parameter 147",255,TYPE_NONE,0,147,   // not described
+  "    ","Parameter 148",255,TYPE_NONE,0,148,   // not described
+  "    ","Parameter 149",255,TYPE_NONE,0,149,   // not described
+  "    ","Parameter 150",255,TYPE_NONE,0,150,   // not described
+  "    ","Parameter 151",255,TYPE_NONE,0,151,   // not described
+  "    ","Parameter 152",255,TYPE_NONE,0,152,   // not described
+  "    ","Parameter 153",255,TYPE_NONE,0,153,   // not described
+  "    ","Parameter 154",255,TYPE_NONE,0,154,   // not described
+  "    ","Parameter 155",255,TYPE_NONE,0,155,   // not described
+  "    ","Parameter 156",255,TYPE_NONE,0,156,   // not described
+  "    ","Parameter 157",255,TYPE_NONE,0,157,   // not described
+  "    ","Parameter 158",255,TYPE_NONE,0,158,   // not described
+  "    ","Parameter 159",255,TYPE_NONE,0,159,   // not described
+  "WAVE","Waveform",9,TYPE_TEXT,textlfowaves,160,   // LFO 1
+  " SPD","Speed",255,TYPE_NUM,0,161,   // LFO 1
+  "SYNC","Sync to Key, Multi",3,TYPE_TEXT,textlfosync,162,   // LFO 1
+  "FADE","Fade in Rate",255,TYPE_NUM,0,163,   // LFO 1
+  "PITC","Pitch Depth",255,TYPE_NUM,0,164,   // LFO 1
+  " AMP","Amplitude Depth",255,TYPE_NUM,0,165,   // LFO 1
+  "RANG","Range",1,TYPE_TEXT,textlforange,166,   // LFO 1
+  "    ","Parameter 167",255,TYPE_NONE,0,167,   // not described
+  "    ","Parameter 168",255,TYPE_NONE,0,168,   // not described
+  "    ","Parameter 169",255,TYPE_NONE,0,169,   // not described
+  "WAVE","Waveform",9,TYPE_TEXT,textlfowaves,170,   // LFO 2
+  " SPD","Speed",255,TYPE_NUM,0,171,   // LFO 2
+  "SYNC","Sync to Key, Multi",3,TYPE_TEXT,textlfosync,172,   // LFO 2
+  "FADE","Fade in Rate",255,TYPE_NUM,0,173,   // LFO 2
+  "  PW","Pulse Width Depth",255,TYPE_NUM,0,174,   // LFO 2
+  " CUT","Filter Cut Depth",255,TYPE_NUM,0,175,   // LFO 2
+  "RANG","Range",1,TYPE_TEXT,textlforange,176,   // LFO 2
+  "    ","Parameter 177",255,TYPE_NONE,0,177,   // not described
+  "    ","Parameter 178",255,TYPE_NONE,0,178,   // not described
+  "    ","Parameter 179",255,TYPE_NONE,0,179,   // not described
+  "PAFT","Aftertouch Pitch",255,TYPE_NUM,0,180,   // LFO 1
+  "PWHL","Mod Wheel Pitch",255,TYPE_NUM,0,181,   // LFO 1
+  "    ","Parameter 182",255,TYPE_NONE,0,182,   // not described
+  "    ","Parameter 183",255,TYPE_NONE,0,183,   // not described
+  "PAFT","Aftertouch Pulse W.",255,TYPE_NUM,0,184,   // LFO 2
+  "PWHL","Mod Wheel Pulse W.",255,TYPE_NUM,0,185,   // LFO 2
+  "    ","Parameter 186",255,TYPE_NONE,0,186,   // not described
+  "    ","Parameter 187",255,TYPE_NONE,0,187,   // not described
+  "CAFT","Aftertouch Filt. Cut",255,TYPE_NUM,0,188,   // LFO 2
+  "CWHL","Mod Wheel Filter Cut",255,TYPE_NUM,0,189,   // LFO 2
+  "    ","Parameter 190",255,TYPE_NONE,0,190,   // not described
+  "    ","Parameter 191",255,TYPE_NONE,0,191,   // not described
+  "AAFT","Aftertouch Amp.",255,TYPE_NUM,0,192,   // LFO 1
+  "AWHL","Mod Wheel Amp.",255,TYPE_NUM,0,193,   // LFO 1
+  "    ","Parameter 194",255,TYPE_NONE,0,194,   // not described
+  "    ","Parameter 195",255,TYPE_NONE,0,195,   // not described
+  "    ","Parameter 196",255,TYPE_NONE,0,196,   // not described
+  "    ","Parameter 197",255,TYPE_NONE,0,197,   // not described
+  "    ","Parameter 198",255,TYPE_NONE,0,198,   // not described
+  "    ","Parameter 199",255,TYPE_NONE,0,199,   // not described
+  "PAFT","Pitch Aftertouch",255,TYPE_NUM,0,200,   // MIDI
+  "    ","Parameter 201",255,TYPE_NONE,0,201,   // not described
+  "    ","Parameter 202",255,TYPE_NONE,0,202,   // not described
+  "PRND","Pitch Random",255,TYPE_NUM,0,203,   // MIDI
+  "PWAF","Pulse W. Aftertouch",255,TYPE_NUM,0,204,   // MIDI
+  "PWWH","Pulse Width Wheel",255,TYPE_NUM,0,205,   // MIDI
+  "    ","Parameter 206",255,TYPE_NONE,0,206,   // not described
+  "    ","Parameter 207",255,TYPE_NONE,0,207,   // not described
+  "CTAF","Cutoff Aftertouch",255,TYPE_NUM,0,208,   // MIDI
+  "CTWH","Cutoff Wheel",255,TYPE_NUM,0,209,   // MIDI
+  "    ","Parameter 210",255,TYPE_NONE,0,210,   // not described
+  "    ","Parameter 211",255,TYPE_NONE,0,211,   // not described
+  "VOAF","Volume Aftertouch",255,TYPE_NUM,0,212,   // MIDI
+  "VOWH","Volume Wheel",255,TYPE_NUM,0,213,   // MIDI
+  "    ","Parameter 214",255,TYPE_NONE,0,214,   // not described
+  "    ","Parameter 215",255,TYPE_NONE,0,215,   // not described
+  "    ","Parameter 216",255,TYPE_NONE,0,216,   // not described
+  "    ","Parameter 217",255,TYPE_NONE,0,217,   // not described
+  "    ","Parameter 218",255,TYPE_NONE,0,218,   // not described
+  "    ","Parameter 219",255,TYPE_NONE,0,219,   // not described
+  "    ","Parameter 220",255,TYPE_NONE,0,220,   // not described
+  "    ","Parameter 221",255,TYPE_NONE,0,221,   // not described
+  "    ","Parameter 222",255,TYPE_NONE,0,222,   // not described
+  "    ","Parameter 223",255,TYPE_NONE,0,223,   // not described
+  "    ","Parameter 224",255,TYPE_NONE,0,224,   // not described
+  "    ","Parameter 225",255,TYPE_NONE,0,225,   // not described
+  "    ","Parameter 226",255,TYPE_NONE,0,226,   // not described
+  "    ","Parameter 227",255,TYPE_NONE,0,227,   // not described
+  "    ","Parameter 228",255,TYPE_NONE,0,228,   // not described
+  "    ","Parameter 229",255,TYPE_NONE,0,229,   // not described
+  "    ","Parameter 230",255,TYPE_NONE,0,230,   // not described
+  "    ","Parameter 231",255,TYPE_NONE,0,231,   // not described
+  "    ","Parameter 232",255,TYPE_NONE,0,232,   // not described
+  "    ","Parameter 233",255,TYPE_NONE,0,233,   // not described
+  "    ","Parameter 234",255,TYPE_NONE,0,234,   // not described
+  "    ","Parameter 235",255,TYPE_NONE,0,235,   // not described
+  "    ","Parameter 236",255,TYPE_NONE,0,236,   // not described
+  "    ","Parameter 237",255,TYPE_NONE,0,237,   // not described
+  "    ","Parameter 238",255,TYPE_NONE,0,238,   // not described
+  "    ","Parameter 239",255,TYPE_NONE,0,239,   // not described
+  "    ","Parameter 240",255,TYPE_NONE,0,240,   // not described
+  "TPOS","Transpose",255,TYPE_NUM,0,241,   // Global Params
+  "BNDU","Bend Up Range",10,TYPE_NUM,0,242,   // Global Params
+  "BNDD","Bend Down Range",10,TYPE_NUM,0,243,   // Global Params
+  "LEGA","Legato Mode",1,TYPE_TEXT,textlegatomode,244,   // Global Params
+  "PMOD","Portamento Mode",2,TYPE_TEXT,textportamode,245,   // Global Params
+  "PTIM","Portamento Time",255,TYPE_NUM,0,246,   // Global Params
+  " PAN","Pan",255,TYPE_NUM,0,247,   // Global Params
+  " VOL","Volume",255,TYPE_NUM,0,248,   // Global Params
+  "VOFF","Velocity Offset",127,TYPE_NUM,0,249,   // Global Params
+  "    ","Parameter 250",255,TYPE_NONE,0,250,   // not described
+  "TUNE","Tuning",255,TYPE_NUM,0,251,   // Global Params
+  "    ","Parameter 252",255,TYPE_NONE,0,252,   // not described
+  "    ","Parameter 253",255,TYPE_NONE,0,253,   // not described
+  "    ","Parameter 254",255,TYPE_NONE,0,254,   // not described
+  "    ","Parameter 255",255,TYPE_NONE,0,255,   // not described
+  "    ","Parameter 256",255,TYPE_NONE,0,256,   // not described
+  "    ","Parameter 257",255,TYPE_NONE,0,257,   // not described
+  "    ","Parameter 258",255,TYPE_NONE,0,258,   // not described
+  "    ","Parameter 259",255,TYPE_NONE,0,259,   // not described
+  "    ","Parameter 260",255,TYPE_NONE,0,260,   // not described
+  "    ","Parameter 261",255,TYPE_NONE,0,261,   // not described
+  "    ","Parameter 262",255,TYPE_NONE,0,262,   // not described
+  "    ","Parameter 263",255,TYPE_NONE,0,263,   // not described
+  "    ","Parameter 264",255,TYPE_NONE,0,264,   // not described
+  "    ","Parameter 265",255,TYPE_NONE,0,265,   // not described
+  "    ","Parameter 266",255,TYPE_NONE,0,266,   // not described
+  "    ","Parameter 267",255,TYPE_NONE,0,267,   // not described
+  "    ","Parameter 268",255,TYPE_NONE,0,268,   // not described
+  "    ","Parameter 269",255,TYPE_NONE,0,269,   // not described
+  "    ","Parameter 270",255,TYPE_NONE,0,270,   // not described
+  "RING","Ringmod 3-4",1,TYPE_TEXT,textoffon,271,   // Oscillator 3
+  "    ","Parameter 272",255,TYPE_NONE,0,272,   // not described
+  "    ","Parameter 273",255,TYPE_NONE,0,273,   // not described
+  "    ","Parameter 274",255,TYPE_NONE,0,274,   // not described
+  "DRIV","Drive",7,TYPE_NUM,0,275,   // Filters
+  "VELR","Velocity Resonance",255,TYPE_NUM,0,276,   // Filters
+  " KBR","Keyboard Resonance",255,TYPE_NUM,0,277,   // Filters
+  "ROUT","Filter Routing",1,TYPE_TEXT,textfiltroute,278,   // Filters
+  "    ","Parameter 279",255,TYPE_NONE,0,279,   // not described
+  "    ","Parameter 280",255,TYPE_NONE,0,280,   // not described
+  "    ","Parameter 281",255,TYPE_NONE,0,281,   // not described
+  "    ","Parameter 282",255,TYPE_NONE,0,282,   // not described
+  "    ","Parameter 283",255,TYPE_NONE,0,283,   // not described
+  "    ","Parameter 284",255,TYPE_NONE,0,284,   // not described
+  "SDET","Sawstack Detune",255,TYPE_NUM,0,285,   // Oscillator 1
+  "SDET","Sawstack Detune",255,TYPE_NUM,0,286,   // Oscillator 2
+  "SDET","Sawstack Detune",255,TYPE_NUM,0,287,   // Oscillator 3
+  "SDET","Sawstack Detune",255,TYPE_NUM,0,288,   // Oscillator 4
+  "    ","Parameter 289",255,TYPE_NONE,0,289,   // not described
+  "    ","Parameter 290",255,TYPE_NONE,0,290,   // not described
+  "SMER","Smear",7,TYPE_NUM,0,291,   // Delay
+  "  2x","2X mode",1,TYPE_TEXT,textoffon,292,   // Delay
+  "    ","Parameter 293",255,TYPE_NONE,0,293,   // not described
+  "    ","Parameter 294",255,TYPE_NONE,0,294,   // not described
+  "    ","Parameter 295",255,TYPE_NONE,0,295,   // not described
+  "    ","Parameter 296",255,TYPE_NONE,0,296,   // not described
+  "    ","Parameter 297",255,TYPE_NONE,0,297,   // not described
+  " SPD","Mod Speed",255,TYPE_NUM,0,298,   // Delay
+  "DPTH","Mod Depth",255,TYPE_NUM,0,299,   // Delay
+  "    ","Parameter 300",255,TYPE_NONE,0,300,   // not described
+  " WET","Delay Level",255,TYPE_NUM,0,301,   // Delay
+  "MODE","Delay Type",4,TYPE_TEXT,textdelaymode,302,   // Delay
+  "TIME","Delay Time",255,TYPE_NUM,0,303,   // Delay
+  "FDBK","Feedback",255,TYPE_NUM,0,304,   // Delay
+  "  LP","Lopass Response",255,TYPE_NUM,0,305,   // Delay
+  "  HP","Hipass Response",255,TYPE_NUM,0,306,   // Delay
+  "TMPO","Tempo",255,TYPE_NUM,0,307,   // Delay
+  " MUL","Tempo Multiplier",255,TYPE_NUM,0,308,   // Delay
+  " DIV","Tempo Divider",255,TYPE_NUM,0,309,   // Delay
+  "    ","Parameter 310",255,TYPE_NONE,0,310,   // not described
+  " WET","Phaser Level",255,TYPE_NUM,0,311,   // Phaser
+  "MODE","Phaser Type",2,TYPE_TEXT,textstereomode,312,   // Phaser
+  "DPTH","Depth",255,TYPE_NUM,0,313,   // Phaser
+  " SPD","Speed",255,TYPE_NUM,0,314,   // Phaser
+  "FDBK","Feedback",255,TYPE_NUM,0,315,   // Phaser
+  "OFFS","Offset",255,TYPE_NUM,0,316,   // Phaser
+  "STAG","Stages",12,TYPE_NUM,0,317,   // Phaser
+  "LRPH","L-R Phase",255,TYPE_NUM,0,318,   // Phaser
+  "    ","Parameter 319",255,TYPE_NONE,0,319,   // not described
+  " LPF","Lowpass Filter",255,TYPE_NUM,0,320,   // Additional Effects
+  " HPF","Highpass Filter",255,TYPE_NUM,0,321,   // Additional Effects
+  "    ","Parameter 322",255,TYPE_NONE,0,322,   // not described
+  "    ","Parameter 323",255,TYPE_NONE,0,323,   // not described
+  "    ","Parameter 324",255,TYPE_NONE,0,324,   // not described
+  "    ","Parameter 325",255,TYPE_NONE,0,325,   // not described
+  "    ","Parameter 326",255,TYPE_NONE,0,326,   // not described
+  "    ","Parameter 327",255,TYPE_NONE,0,327,   // not described
+  "    ","Parameter 328",255,TYPE_NONE,0,328,   // not described
+  "    ","Parameter 329",255,TYPE_NONE,0,329,   // not described
+  "  AM","Amp Mod Level",255,TYPE_NUM,0,330,   // Performance
+  " SPD","Speed",255,TYPE_NUM,0,331,   // Amplitude Modulator
+  "RANG","Speed Range",255,TYPE_NUM,0,332,   // Amplitude Modulator
+  "LRPH","L-R Phase",255,TYPE_NUM,0,333,   // Amplitude Modulator
+  "    ","Parameter 334",255,TYPE_NONE,0,334,   // not described
+  "    ","Parameter 335",255,TYPE_NONE,0,335,   // not described
+  "    ","Parameter 336",255,TYPE_NONE,0,336,   // not described
+  "    ","Parameter 337",255,TYPE_NONE,0,337,   // not described
+  "    ","Parameter 338",255,TYPE_NONE,0,338,   // not described
+  "    ","Parameter 339",255,TYPE_NONE,0,339,   // not described
+  "    ","Parameter 340",255,TYPE_NONE,0,340,   // not described
+  "    ","Parameter 341",255,TYPE_NONE,0,341,   // not described
+  "    ","Parameter 342",255,TYPE_NONE,0,342,   // not described
+  "    ","Parameter 343",255,TYPE_NONE,0,343,   // not described
+  "    ","Parameter 344",255,TYPE_NONE,0,344,   // not described
+  "    ","Parameter 345",255,TYPE_NONE,0,345,   // not described
+  "    ","Parameter 346",255,TYPE_NONE,0,346,   // not described
+  "    ","Parameter 347",255,TYPE_NONE,0,347,   // not described
+  "    ","Parameter 348",255,TYPE_NONE,0,348,   // not described
+  "    ","Parameter 349",255,TYPE_NONE,0,349,   // not described
+  "DIST","Distortion On/Off",1,TYPE_TEXT,textoffon,350,   // Additional Effects
+  " PRE","Pre Dist. Gain",255,TYPE_NUM,0,351,   // Additional Effects
+  "POST","Post Dist. Gain",255,TYPE_NUM,0,352,   // Additional Effects
+  "FILT","Post Dist. Filter",7,TYPE_TEXT,textdfilt,353,   // Additional Effects
+  "DTYP","Distortion Type",3,TYPE_TEXT,textdtype,354,   // Additional Effects
+  "    ","Parameter 355",255,TYPE_NONE,0,355,   // not described
+  "    ","Parameter 356",255,TYPE_NONE,0,356,   // not described
+  "    ","Parameter 357",255,TYPE_NONE,0,357,   // not described
+  "    ","Parameter 358",255,TYPE_NONE,0,358,   // not described
+  "    ","Parameter 359",255,TYPE_NONE,0,359,   // not described
+  "    ","Parameter 360",255,TYPE_NONE,0,360,   // not described
+  " WET","Chorus Level",255,TYPE_NUM,0,361,   // Chorus/Flanger
+  "MODE","Chorus Type",2,TYPE_TEXT,textstereomode,362,   // Chorus/Flanger
+  " SPD","Speed",255,TYPE_NUM,0,363,   // Chorus/Flanger
+  "DPTH","Depth",255,TYPE_NUM,0,364,   // Chorus/Flanger
+  "FDBK","Feedback",255,TYPE_NUM,0,365,   // Chorus/Flanger
+  "LRPH","L-R Phase",255,TYPE_NUM,0,366,   // Chorus/Flanger
+  "    ","Parameter 367",255,TYPE_NONE,0,367,   // not described
+  "    ","Parameter 368",255,TYPE_NONE,0,368,   // not described
+  "    ","Parameter 369",255,TYPE_NONE,0,369,   // not described
+  "DECI","Decimator Depth",23,TYPE_NUM,0,370,   // Additional Effects
+  "    ","Parameter 371",255,TYPE_NONE,0,371,   // not described
+  "    ","Parameter 372",255,TYPE_NONE,0,372,   // not described
+  "    ","Parameter 373",255,TYPE_NONE,0,373,   // not described
+  "    ","Parameter 374",255,TYPE_NONE,0,374,   // not described
+  "    ","Parameter 375",255,TYPE_NONE,0,375,   // not described
+  "    ","Parameter 376",255,TYPE_NONE,0,376,   // not described
+  "    ","Parameter 377",255,TYPE_NONE,0,377,   // not described
+  "    ","Parameter 378",255,TYPE_NONE,0,378,   // not described
+  "    ","Parameter 379",255,TYPE_NONE,0,379,   // not described
+  "CRSH","Bitcrusher Depth",24,TYPE_NUM,0,380,   // Additional Effects
+  "    ","Parameter 381",255,TYPE_NONE,0,381,   // not described
+  "    ","Parameter 382",255,TYPE_NONE,0,382,   // not described
+  "    ","Parameter 383",255,TYPE_NONE,0,383,   // not described
+  "    ","Parameter 384",255,TYPE_NONE,0,384,   // not described
+  "ENAB","Gate Enable",1,TYPE_TEXT,textoffon,385,   // Gate
+  "CURV","Curve Shape",1,TYPE_NUM,0,386,   // Gate
+  "ATTK","Attack",255,TYPE_NUM,0,387,   // Gate
+  "RELS","Release",255,TYPE_NUM,0,388,   // Gate
+  "    ","Parameter 389",255,TYPE_NONE,0,389,   // not described
+  "    ","Parameter 390",255,TYPE_NONE,0,390,   // not described
+  " WET","Reverb Level",255,TYPE_NUM,0,391,   // Reverb
+  "MODE","Reverb Type",1,TYPE_TEXT,textrvbmode,392,   // Reverb
+  "DCAY","Decay Time",255,TYPE_NUM,0,393,   // Reverb
+  "DAMP","H.F. Damping",255,TYPE_NUM,0,394,   // Reverb
+  " SPD","Tail Mod Speed",255,TYPE_NUM,0,395,   // Reverb
+  "DPTH","Tail Mod Level",255,TYPE_NUM,0,396,   // Reverb
+  " HPF","Tail L.F. Cut",255,TYPE_NUM,0,397,   // Reverb
+  "    ","Parameter 398",255,TYPE_NONE,0,398,   // not described
+  "    ","Parameter 399",255,TYPE_NONE,0,399,   // not described
+  "CL1L","Control 1 HI",255,TYPE_NUM,0,400,   // MIDI
+  "CL1H","Control 1 LO",255,TYPE_NUM,0,401,   // MIDI
+  "CL2L","Control 2 HI",255,TYPE_NUM,0,402,   // MIDI
+  "CL2H","Control 2 LO",255,TYPE_NUM,0,403,   // MIDI
+  "CL3L","Control 3 HI",255,TYPE_NUM,0,404,   // MIDI
+  "CL3H","Control 3 LO",255,TYPE_NUM,0,405,   // MIDI
+  "CL4L","Control 4 HI",255,TYPE_NUM,0,406,   // MIDI
+  "CL4H","Control 4 LO",255,TYPE_NUM,0,407,   // MIDI
+  "    ","Parameter 408",255,TYPE_NONE,0,408,   // not described
+  "    ","Parameter 409",255,TYPE_NONE,0,409,   // not described
+  "    ","Parameter 410",255,TYPE_NONE,0,410,   // not described
+  "    ","Parameter 411",255,TYPE_NONE,0,411,   // not described
+  "    ","Parameter 412",255,TYPE_NONE,0,412,   // not described
+  "    ","Parameter 413",255,TYPE_NONE,0,413,   // not described
+  "    ","Parameter 414",255,TYPE_NONE,0,414,   // not described
+  "    ","Parameter 415",255,TYPE_NONE,0,415,   // not described
+  "    ","Parameter 416",255,TYPE_NONE,0,416,   // not described
+  "    ","Parameter 417",255,TYPE_NONE,0,417,   // not described
+  "    ","Parameter 418",255,TYPE_NONE,0,418,   // not described
+  "    ","Parameter 419",255,TYPE_NONE,0,419,   // not described
+  "    ","Parameter 420",255,TYPE_NONE,0,420,   // not described
+  "    ","Parameter 421",255,TYPE_NONE,0,421,   // not described
+  "    ","Parameter 422",255,TYPE_NONE,0,422,   // not described
+  "    ","Parameter 423",255,TYPE_NONE,0,423,   // not described
+  "    ","Parameter 424",255,TYPE_NONE,0,424,   // not described
+  "    ","Parameter 425",255,TYPE_NONE,0,425,   // not described
+  "    ","Parameter 426",255,TYPE_NONE,0,426,   // not described
+  "    ","Parameter 427",255,TYPE_NONE,0,427,   // not described
+  " SEQ","Sequencer On/Off",1,TYPE_TEXT,textoffon,428,   // Performance
+  "VELO","Velocity",127,TYPE_NUM,0,429,   // Sequencer
+  "STPS","Seq. Length",16,TYPE_NUM,0,430,   // Sequencer
+  "TMPO","Tempo",255,TYPE_NUM,0,431,   // Sequencer
+  " MUL","Tempo Multiplier",10,TYPE_NUM,0,432,   // Sequencer
+  "TPOS","Transpose",255,TYPE_NUM,0,433,   // Sequencer
+  "   1","Step 1",255,TYPE_NUM,0,434,   // Sequencer
+  "   2","Step 2",255,TYPE_NUM,0,435,   // Sequencer
+  "   3","Step 3",255,TYPE_NUM,0,436,   // Sequencer
+  "   4","Step 4",255,TYPE_NUM,0,437,   // Sequencer
+  "   5","Step 5",255,TYPE_NUM,0,438,   // Sequencer
+  "   6","Step 6",255,TYPE_NUM,0,439,   // Sequencer
+  "   7","Step 7",255,TYPE_NUM,0,440,   // Sequencer
+  "   8","Step 8",255,TYPE_NUM,0,441,   // Sequencer
+  "   9","Step 9",255,TYPE_NUM,0,442,   // Sequencer
+  "  10","Step 10",255,TYPE_NUM,0,443,   // Sequencer
+  "  11","Step 11",255,TYPE_NUM,0,444,   // Sequencer
+  "  12","Step 12",255,TYPE_NUM,0,445,   // Sequencer
+  "  13","Step 13",255,TYPE_NUM,0,446,   // Sequencer
+  "  14","Step 14",255,TYPE_NUM,0,447,   // Sequencer
+  "  15","Step 15",255,TYPE_NUM,0,448,   // Sequencer
+  "  16","Step 16",255,TYPE_NUM,0,449,   // Sequencer
+  "MODE","Arp Mode",5,TYPE_TEXT,textarpmode,450,   // Arpeggiator
+  "TMPO","Tempo (min 44)",255,TYPE_NUM,0,451,   // Arpeggiator
+  "    ","Parameter 452",255,TYPE_NONE,0,452,   // not described
+  " MUL","Tempo Multiplier",10,TYPE_NUM,0,453,   // Arpeggiator
+  " OCT","Octaves",10,TYPE_NUM,0,454,   // Arpeggiator
+  "    ","Parameter 455",255,TYPE_NONE,0,455,   // not described
+  "    ","Parameter 456",255,TYPE_NONE,0,456,   // not described
+  "    ","Parameter 457",255,TYPE_NONE,0,457,   // not described
+  "    ","Parameter 458",255,TYPE_NONE,0,458,   // not described
+  "    ","Parameter 459",255,TYPE_NONE,0,459,   // not described
+  "    ","Parameter 460",255,TYPE_NONE,0,460,   // not described
+  "    ","Parameter 461",255,TYPE_NONE,0,461,   // not described
+  "    ","Parameter 462",255,TYPE_NONE,0,462,   // not described
+  "    ","Parameter 463",255,TYPE_NONE,0,463,   // not described
+  "    ","Parameter 464",255,TYPE_NONE,0,464,   // not described
+  "    ","Parameter 465",255,TYPE_NONE,0,465,   // not described
+  "    ","Parameter 466",255,TYPE_NONE,0,466,   // not described
+  "    ","Parameter 467",255,TYPE_NONE,0,467,   // not described
+  "    ","Parameter 468",255,TYPE_NONE,0,468,   // not described
+  "    ","Parameter 469",255,TYPE_NONE,0,469,   // not described
+  "    ","Parameter 470",255,TYPE_NONE,0,470,   // not described
+  "    ","Parameter 471",255,TYPE_NONE,0,471,   // not described
+  "    ","Parameter 472",255,TYPE_NONE,0,472,   // not described
+  "    ","Parameter 473",255,TYPE_NONE,0,473,   // not described
+  "    ","Parameter 474",255,TYPE_NONE,0,474,   // not described
+  "    ","Parameter 475",255,TYPE_NONE,0,475,   // not described
+  "    ","Parameter 476",255,TYPE_NONE,0,476,   // not described
+  "    ","Parameter 477",255,TYPE_NONE,0,477,   // not described
+  "    ","Parameter 478",255,TYPE_NONE,0,478,   // not described
+  "    ","Parameter 479",255,TYPE_NONE,0,479,   // not described
+  "    ","Parameter 480",255,TYPE_NONE,0,480,   // not described
+  "    ","Parameter 481",255,TYPE_NONE,0,481,   // not described
+  "    ","Parameter 482",255,TYPE_NONE,0,482,   // not described
+  "    ","Parameter 483",255,TYPE_NONE,0,483,   // not described
+  "    ","Parameter 484",255,TYPE_NONE,0,484,   // not described
+  "    ","Parameter 485",255,TYPE_NONE,0,485,   // not described
+  "    ","Parameter 486",255,TYPE_NONE,0,486,   // not described
+  "    ","Parameter 487",255,TYPE_NONE,0,487,   // not described
+  "    ","Parameter 488",255,TYPE_NONE,0,488,   // not described
+  "    ","Parameter 489",255,TYPE_NONE,0,489,   // not described
+  "    ","Parameter 490",255,TYPE_NONE,0,490,   // not described
+  "    ","Parameter 491",255,TYPE_NONE,0,491,   // not described
+  "    ","Parameter 492",255,TYPE_NONE,0,492,   // not described
+  "    ","Parameter 493",255,TYPE_NONE,0,493,   // not described
+  "    ","Parameter 494",255,TYPE_NONE,0,494,   // not described
+  "    ","Parameter 495",255,TYPE_NONE,0,495,   // not described
+  "    ","Parameter 496",255,TYPE_NONE,0,496,   // not described
+  "    ","Parameter 497",255,TYPE_NONE,0,497,   // not described
+  "    ","Parameter 498",255,TYPE_NONE,0,498,   // not described
+  "    ","Parameter 499",255,TYPE_NONE,0,499,   // not described
+  "    ","Parameter 500",255,TYPE_NONE,0,500,   // not described
+  "    ","Parameter 501",255,TYPE_NONE,0,501,   // not described
+  "    ","Parameter 502",255,TYPE_NONE,0,502,   // not described
+  "    ","Parameter 503",255,TYPE_NONE,0,503,   // not described
+  "    ","Parameter 504",255,TYPE_NONE,0,504,   // not described
+  "    ","Parameter 505",255,TYPE_NONE,0,505,   // not described
+  "    ","Parameter 506",255,TYPE_NONE,0,506,   // not described
+  "    ","Parameter 507",255,TYPE_NONE,0,507,   // not described
+  "    ","Parameter 508",255,TYPE_NONE,0,508,   // not described
+  "    ","Parameter 509",255,TYPE_NONE,0,509,   // not described
+  " PRE","Pre FX Gain",3,TYPE_TEXT,textgain,510,   // Additional Effects
+  "POST","Post FX Gain",3,TYPE_TEXT,textgain,511,   // Additional Effects
+};
+
+#endif // PARAMTABLE_H_
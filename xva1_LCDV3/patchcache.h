@@ -0,0 +1,198 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// RAM cache of patch images from the XVA1 memory slots
+// loading a patch is an 'r' plus a 512 byte 'd' dump. once a slot's image is cached, loading it again only needs the 'r' -
+// the image is copied into the parameter array right away so the editor shows the new patch while the synth switches
+// while the user sits on a slot in the Load Patch menu, cache_prefetch() reads the neighbouring slots into the cache in the
+// background so scrolling on finds them there. the synth can only read a slot by loading it, so cache_readslot() follows
+// each read with an 'r' of the loaded slot to put it back and an upload of the changed parameters on top. writes are held
+// from the read until then so none land on the wrong patch, and the sketch's slotrestored callback puts back what isn't in
+// the parameter array - the volume pot. reading a slot switches the sound, so the sketch only prefetches while no notes
+// are coming in. SysEx exports read slots the same way
+// entries carry a checksum that is checked the first time an image is used, and a save to a slot replaces its entry.
+// browsing only looks up which slots are cached, so a pass of loop() in the Load Patch menu doesn't checksum anything
+
+#ifndef PATCHCACHE_H_
+#define PATCHCACHE_H_
+
+#define PATCHCACHE_ENTRIES 32   // 32 x 512 bytes = 16k of RAM
+#define PREFETCH_DELAY 300      // ms the selected slot has to sit still before we prefetch around it
+#define PREFETCH_RANGE 2        // number of slots prefetched on each side of the selected slot
+#define PREFETCH_QUIET 2000     // ms without a MIDI note before prefetching - see above
+#define NUM_SLOTS 128           // XVA1 memory slots
+
+struct cacheentry {
+  int16_t slot;                 // memory slot, -1 if the entry is empty
+  uint16_t checksum;            // of image
+  bool checked;                 // checksum verified since the image was stored
+  uint32_t lastused;            // for least recently used replacement
+  uint8_t image[SYNTH_PARAMS];
+};
+
+struct cacheentry patchcache[PATCHCACHE_ENTRIES];
+uint32_t cacheclock;            // bumped on every use
+uint8_t cachefill[SYNTH_PARAMS]; // prefetch dumps land here
+int16_t prefetchslot=-1;        // slot being prefetched, -1 if none
+int16_t prefetchdone=-1;        // selected slot whose neighbours are all cached, -1 if none
+bool slotreading;               // a slot read has the synth on another patch until cache_restored()
+synthcallback slotrestored;     // set by the sketch - called when the loaded slot is back on the synth after a read
+int16_t loadedslot=-1;          // slot the synth's current patch came from, -1 if it didn't come from a slot
+unsigned long slotchangetime;   // millis() when the selected slot last changed
+
+// cache statistics
+uint32_t cachehits;
+uint32_t cachemisses;
+uint32_t cacheprefetches;
+uint16_t cachebad;              // entries thrown out because the checksum didn't match
+
+// Fletcher-16 of a patch image
+uint16_t patch_checksum(const uint8_t * image) {
+  uint16_t a=0, b=0;
+  for (uint16_t i=0; i < SYNTH_PARAMS; ++i) {
+    a=(a+image[i]) % 255;
+    b=(b+a) % 255;
+  }
+  return (b << 8) | a;
+}
+
+void cache_init(void) {
+  for (uint8_t i=0; i < PATCHCACHE_ENTRIES; ++i) patchcache[i].slot=-1;
+}
+
+// find a slot's entry, returns NULL if it isn't cached
+struct cacheentry * cache_find(uint8_t slot) {
+  for (uint8_t i=0; i < PATCHCACHE_ENTRIES; ++i) {
+    if (patchcache[i].slot == slot) return &patchcache[i];
+  }
+  return NULL;
+}
+
+// find a slot's entry to use its image, returns NULL if it isn't cached or the image is damaged
+// the checksum is only verified the first time an entry is used
+struct cacheentry * cache_use(uint8_t slot) {
+  struct cacheentry * e=cache_find(slot);
+  if ((e == NULL) || e->checked) return e;
+  if (patch_checksum(e->image) != e->checksum) {
+    e->slot=-1;
+    ++cachebad;
+    return NULL;
+  }
+  e->checked=true;
+  return e;
+}
+
+// put a slot's image in the cache, replacing its old entry or the least recently used one
+void cache_store(uint8_t slot, const uint8_t * image) {
+  struct cacheentry * e=NULL;
+  for (uint8_t i=0; i < PATCHCACHE_ENTRIES; ++i) {
+    if (patchcache[i].slot == slot) {
+      e=&patchcache[i];
+      break;
+    }
+    if ((e == NULL) || (patchcache[i].slot < 0) || ((e->slot >= 0) && (patchcache[i].lastused < e->lastused))) e=&patchcache[i];
+  }
+  memcpy(e->image,image,SYNTH_PARAMS);
+  e->checksum=patch_checksum(image);
+  e->checked=false;
+  e->slot=slot;
+  e->lastused=++cacheclock;
+  prefetchdone=-1;  // may have replaced a neighbour of the selected slot
+}
+
+void cache_invalidate(uint8_t slot) {
+  for (uint8_t i=0; i < PATCHCACHE_ENTRIES; ++i) {
+    if (patchcache[i].slot == slot) patchcache[i].slot=-1;
+  }
+  prefetchdone=-1;
+}
+
+// copy a cached slot into the parameter array
+// returns false if the slot isn't cached
+bool cache_apply(uint8_t slot) {
+  struct cacheentry * e=cache_use(slot);
+  if (e == NULL) {
+    ++cachemisses;
+    return false;
+  }
+  ++cachehits;
+  e->lastused=++cacheclock;
+  memcpy(parameters,e->image,SYNTH_PARAMS);
+  return true;
+}
+
+// a prefetch dump finished
+void cache_prefetched(uint8_t, uint8_t result) {
+  if ((result == SYNTH_OK) && (prefetchslot >= 0)) {
+    cache_store(prefetchslot,cachefill);
+    ++cacheprefetches;
+  }
+  prefetchslot=-1;
+}
+
+// the loaded slot and its edits are back on the synth - let the writes go again
+void cache_restored(uint8_t cmd, uint8_t result) {
+  slotreading=false;
+  sched_hold(false);
+  if (slotrestored) slotrestored(cmd,result);
+}
+
+// true if the synth's patch can be put back after reading another slot - it is a memory slot plus the edited parameters
+bool cache_canread(void) {
+  return (loadedslot >= 0) && (editbase == loadedslot);
+}
+
+// read a slot into image thru the synth's edit buffer - done is called when the read finishes
+// the loaded slot is recalled after it and the edits are uploaded on top. returns false if that can't be done
+bool cache_readslot(uint8_t slot, uint8_t * image, synthcallback done) {
+  if (slotreading || !cache_canread() || (synth_room() < 3)) return false;
+  slotreading=true;
+  sched_hold(true);
+  synth_queue(CMD_READ,slot,0,image,done);
+  synth_queue(CMD_RECALL,loadedslot,0,0,NULL);  // back to the loaded patch
+  synth_queue(CMD_UPLOAD,UPLOAD_EDITED,0,parameters,cache_restored);
+  return true;
+}
+
+// background prefetch - call every pass of loop()
+// selected is the slot shown in the Load Patch menu, browsing is true while that menu is on screen and prefetching is ok
+// once all the neighbours of the selected slot are cached it returns at once until the cache or the selection changes
+void cache_prefetch(uint8_t selected, bool browsing) {
+  if (!browsing || (selected == prefetchdone) || synth_busy() || (writeqcount != 0) || (prefetchslot >= 0)) return;
+  if ((millis() - slotchangetime) < PREFETCH_DELAY) return;
+  if (loadedslot != selected) return;  // the synth isn't on the selected slot
+  for (int8_t d=1; d <= PREFETCH_RANGE; ++d) {
+    for (int8_t dir=1; dir >= -1; dir-=2) {
+      int16_t slot=selected+d*dir;
+      if ((slot < 0) || (slot >= NUM_SLOTS) || cache_find(slot)) continue;
+      if (cache_readslot(slot,cachefill,cache_prefetched)) prefetchslot=slot;
+      return;
+    }
+  }
+  prefetchdone=selected;
+}
+
+#endif // PATCHCACHE_H_
@@ -0,0 +1,157 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+//
+// compact patch encoding for storing patches in flash
+// most patches only change a few dozen of the 512 parameters from the init patch, so a patch is coded as the difference
+// from a base image (normally the init patch, but any image works) with run length coding. the coded patch is a list of ops:
+//   0x00-0x7F  1-128 bytes the same as the base
+//   0x80-0xBF  1-64 literal bytes follow
+//   0xC0-0xFF  3-66 copies of the next byte
+// a patch that is the base codes to 4 bytes, a typical edited patch to well under 100
+// a single byte the same as the base goes into a literal rather than a same op of its own, which keeps the worst case to
+// CODEC_MAXLEN: same and run ops code at least one byte more than they cost, a literal costs one more than it codes, and a
+// literal is only followed by another when it is full, so there are at most SYNTH_PARAMS/CODEC_MAXLITERAL+1 more literals
+// than other ops
+
+#ifndef PATCHCODEC_H_
+#define PATCHCODEC_H_
+
+#define CODEC_SAME 0x00
+#define CODEC_LITERAL 0x80
+#define CODEC_RUN 0xC0
+#define CODEC_MAXSAME 128
+#define CODEC_MAXLITERAL 64
+#define CODEC_MINRUN 3
+#define CODEC_MAXRUN 66
+#define CODEC_MAXLEN (SYNTH_PARAMS+SYNTH_PARAMS/CODEC_MAXLITERAL+1) // worst case - see above
+
+// number of bytes from i on that are the same as the base
+uint16_t codec_same(const uint8_t * image, const uint8_t * base, uint16_t i) {
+  uint16_t n=0;
+  while ((i+n < SYNTH_PARAMS) && (n < CODEC_MAXSAME) && (image[i+n] == base[i+n])) ++n;
+  return n;
+}
+
+// number of bytes from i on with the same value
+uint16_t codec_run(const uint8_t * image, uint16_t i) {
+  uint16_t n=1;
+  while ((i+n < SYNTH_PARAMS) && (n < CODEC_MAXRUN) && (image[i+n] == image[i])) ++n;
+  return n;
+}
+
+// code image against base into out, which must hold CODEC_MAXLEN bytes
+// returns the coded length
+uint16_t codec_encode(const uint8_t * image, const uint8_t * base, uint8_t * out) {
+  uint16_t i=0, len=0, n;
+  while (i < SYNTH_PARAMS) {
+    n=codec_same(image,base,i);
+    if (n >= 2) {  // a single one is cheaper in a literal
+      out[len++]=CODEC_SAME | (n-1);
+      i+=n;
+      continue;
+    }
+    n=codec_run(image,i);
+    if (n >= CODEC_MINRUN) {
+      out[len++]=CODEC_RUN | (n-CODEC_MINRUN);
+      out[len++]=image[i];
+      i+=n;
+      continue;
+    }
+    // literals up to the next stretch that is cheaper coded some other way. a single byte the same as the base costs
+    // as much as it does in the literal so it doesn't end one
+    uint16_t start=i;
+    n=0;
+    while ((i < SYNTH_PARAMS) && (n < CODEC_MAXLITERAL) && (codec_same(image,base,i) < 2) && (codec_run(image,i) < CODEC_MINRUN)) {
+      ++i;
+      ++n;
+    }
+    out[len++]=CODEC_LITERAL | (n-1);
+    memcpy(&out[len],&image[start],n);
+    len+=n;
+  }
+  return len;
+}
+
+// rebuild an image from its code and the base it was coded against
+// returns false if the code is damaged
+bool codec_decode(const uint8_t * in, uint16_t len, const uint8_t * base, uint8_t * image) {
+  uint16_t i=0, pos=0, n;
+  while (pos < len) {
+    uint8_t op=in[pos++];
+    if (op < CODEC_LITERAL) {
+      n=(op & 0x7F)+1;
+      if (i+n > SYNTH_PARAMS) return false;
+      memcpy(&image[i],&base[i],n);
+    }
+    else if (op < CODEC_RUN) {
+      n=(op & 0x3F)+1;
+      if ((i+n > SYNTH_PARAMS) || (pos+n > len)) return false;
+      memcpy(&image[i],&in[pos],n);
+      pos+=n;
+    }
+    else {
+      n=(op & 0x3F)+CODEC_MINRUN;
+      if ((i+n > SYNTH_PARAMS) || (pos >= len)) return false;
+      memset(&image[i],in[pos++],n);
+    }
+    i+=n;
+  }
+  return i == SYNTH_PARAMS;
+}
+
+// code every patch in the patch cache against base and print the compression and timing on the serial port
+// load or prefetch a few slots first so there is a corpus of real patches to work on
+void codec_benchmark(const uint8_t * base, const char * basename) {
+  static uint8_t code[CODEC_MAXLEN];
+  static uint8_t check[SYNTH_PARAMS];
+  uint32_t patches=0, coded=0, enctime=0, dectime=0, failed=0;
+  uint16_t smallest=0xFFFF, largest=0;
+  for (uint8_t e=0; e < PATCHCACHE_ENTRIES; ++e) {
+    if (patchcache[e].slot < 0) continue;
+    uint32_t start=micros();
+    uint16_t len=codec_encode(patchcache[e].image,base,code);
+    enctime+=micros()-start;
+    start=micros();
+    bool ok=codec_decode(code,len,base,check);
+    dectime+=micros()-start;
+    if (!ok || memcmp(check,patchcache[e].image,SYNTH_PARAMS)) ++failed;
+    ++patches;
+    coded+=len;
+    if (len < smallest) smallest=len;
+    if (len > largest) largest=len;
+  }
+  if (patches == 0) {
+    Serial.println("codec benchmark: no patches in the cache");
+    return;
+  }
+  Serial.printf("codec benchmark against %s: %u patches %u bytes coded to %u, ratio %u.%02u:1\n",basename,patches,patches*SYNTH_PARAMS,coded,
+    patches*SYNTH_PARAMS/coded,(patches*SYNTH_PARAMS*100/coded) % 100);
+  Serial.printf("  smallest %u largest %u average %u bytes\n",smallest,largest,coded/patches);
+  Serial.printf("  encode %u us decode %u us per patch, %u failed\n",enctime/patches,dectime/patches,failed);
+}
+
+#endif // PATCHCODEC_H_
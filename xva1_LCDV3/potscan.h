@@ -0,0 +1,153 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+//
+// -----------------------------------------------------------------------------
+//
+// background A/D sampling of the pots
+// a timer interrupt calls pot_service() which finishes the last conversion and starts the next one with the non blocking
+// adcStart()/adcEnd() calls, one channel per tick round robin - loop() never waits for the A/D
+// each channel is smoothed by a 1 pole IIR filter and followed with a dead band so the position only moves when the pot does:
+// the tracked reading stays put while the filtered one is within POT_HYSTERESIS of it and is dragged along behind it
+// otherwise. the tracked reading is published as a 10 bit position that moves one count at a time as the pot turns, so
+// pot_scale() reaches every value of any range. the ISR bumps a per channel change count and loop() picks up the changes
+// with pot_event()
+// don't analogRead() a channel the scanner owns - the A/D can only do one conversion at a time
+
+#ifndef POTSCAN_H_
+#define POTSCAN_H_
+
+#define POT_TIMER_MICROS 250    // one conversion per tick - each of N channels is sampled at 4000/N hz
+#define POT_MAXCHANNELS 8
+#define POT_FILTER 5            // IIR coefficient is 1/2^POT_FILTER - 1/32 is an 8ms time constant at 4khz
+#define POT_ADCMAX 4095         // 12 bit A/D
+#define POT_BITS 10             // published positions are 0..1023
+#define POT_SHIFT (12-POT_BITS)
+#define POT_HYSTERESIS 16       // A/D counts the filtered reading can wander either side of the tracked one - one step of a 0-255 range
+
+struct potchannel {
+  uint8_t pin;
+  bool primed;                  // the filter has its first sample
+  uint32_t acc;                 // filter state, reading << POT_FILTER
+  uint16_t tracked;             // follows the filtered reading with the dead band, POT_HYSTERESIS..POT_ADCMAX-POT_HYSTERESIS
+  uint16_t position;            // published position
+  volatile uint8_t changes;     // bumped by the ISR each time position changes
+  uint8_t seen;                 // changes loop() has picked up
+};
+
+struct potevent {
+  uint8_t channel;
+  uint16_t position;
+};
+
+struct potchannel pots[POT_MAXCHANNELS];
+uint8_t potcount;
+int8_t potconverting=-1;        // channel with a conversion running, -1 if none
+
+// statistics
+volatile uint32_t potsamples;
+uint32_t potevents;
+
+// add a pot, returns its channel number or -1 if there's no room
+// call before the sampling timer is started
+int8_t pot_attach(uint8_t pin) {
+  if (potcount >= POT_MAXCHANNELS) return -1;
+  adcAttachPin(pin);
+  pots[potcount].pin=pin;
+  pots[potcount].primed=false;
+  return potcount++;
+}
+
+// tracked reading to a position - the ends of the tracked range are the ends of the pot
+uint16_t ICACHE_RAM_ATTR pot_scaletracked(uint16_t tracked) {
+  return ((uint32_t)(tracked-POT_HYSTERESIS) << POT_BITS)/(POT_ADCMAX+1-2*POT_HYSTERESIS);
+}
+
+// filter a new reading and move the published position if the pot has really moved
+void ICACHE_RAM_ATTR pot_filter(struct potchannel * p, uint16_t reading) {
+  if (!p->primed) {  // start the filter at the first reading instead of ramping up from 0
+    p->acc=(uint32_t)reading << POT_FILTER;
+    p->primed=true;
+    p->tracked=(reading < POT_HYSTERESIS) ? POT_HYSTERESIS : (reading > POT_ADCMAX-POT_HYSTERESIS) ? POT_ADCMAX-POT_HYSTERESIS : reading;
+    p->position=pot_scaletracked(p->tracked);
+    p->changes=p->changes+1;
+    return;
+  }
+  p->acc+=reading-(p->acc >> POT_FILTER);
+  uint16_t filtered=p->acc >> POT_FILTER;
+  if (filtered > p->tracked+POT_HYSTERESIS) p->tracked=filtered-POT_HYSTERESIS;
+  else if (filtered+POT_HYSTERESIS < p->tracked) p->tracked=filtered+POT_HYSTERESIS;
+  else return;
+  uint16_t position=pot_scaletracked(p->tracked);
+  if (position == p->position) return;
+  p->position=position;
+  __asm__ __volatile__("" ::: "memory"); // position must be written before loop() can see the change
+  p->changes=p->changes+1;
+}
+
+// call from the sampling timer interrupt every POT_TIMER_MICROS
+void ICACHE_RAM_ATTR pot_service(void) {
+  if (potcount == 0) return;
+  if (potconverting >= 0) {
+    struct potchannel * p=&pots[potconverting];
+    if (adcBusy(p->pin)) return;  // not done yet - try again next tick
+    pot_filter(p,adcEnd(p->pin));
+    ++potsamples;
+  }
+  potconverting=(potconverting+1) % potcount;
+  adcStart(pots[potconverting].pin);
+}
+
+// get the next pot that has moved since the last call, returns false if none has
+// a pot that moved several times between calls shows up once with its latest position
+bool pot_event(struct potevent & ev) {
+  for (uint8_t i=0; i < potcount; ++i) {
+    struct potchannel * p=&pots[i];
+    uint8_t changes=p->changes;
+    if (changes == p->seen) continue;
+    __asm__ __volatile__("" ::: "memory");
+    p->seen=changes;
+    ev.channel=i;
+    ev.position=p->position;
+    ++potevents;
+    return true;
+  }
+  return false;
+}
+
+// current position of a pot, false if it hasn't been read yet
+bool pot_position(uint8_t channel, uint16_t * position) {
+  if ((channel >= potcount) || !pots[channel].primed) return false;
+  *position=pots[channel].position;
+  return true;
+}
+
+// scale a position to a parameter range 0..range
+uint8_t pot_scale(uint16_t position, uint8_t range) {
+  return ((uint32_t)position*(range+1)) >> POT_BITS;
+}
+
+#endif // POTSCAN_H_
@@ -0,0 +1,234 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+//
+// patch library on an SD card - only built when SDCARD is defined
+// all patches live in one packed file so browsing and loading never scan a directory:
+//   superblock  512 bytes - magic, version, number of entries
+//   index       LIB_ENTRIES fixed size entries - number, name, hash and file offset of the patch
+//   patches     512 byte images, appended as entries are first saved
+// entry n's index record is at a fixed place so browsing is one seek and one read, loading is one more for the image
+// saves are journaled: the new index entry and image go to a separate journal file with a CRC and a commit marker first,
+// then into the library. a journal with a commit marker is replayed at startup and before the next save and is kept until
+// it has been written to the library, one without is thrown away, so a power cut or a failed write leaves either the old
+// patch or the new one
+
+#ifndef SDLIBRARY_H_
+#define SDLIBRARY_H_
+
+#ifdef SDCARD
+
+#include <SPI.h>
+#include <SD.h>
+
+#define LIB_FILE "/xva1lib.bin"
+#define LIB_JOURNAL "/xva1lib.jnl"
+#define LIB_MAGIC 0x4C314158     // "XA1L"
+#define LIB_JMAGIC 0x4A314158    // "XA1J"
+#define LIB_COMMIT 0x54494D43    // "CMIT" - follows a complete journal record
+#define LIB_VERSION 1
+#define LIB_ENTRIES (LIB_BANKS*LIB_PERBANK)
+#define LIB_NAMELEN 20
+#define LIB_INDEX 512            // file offset of the index
+
+struct libsuper {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t entries;              // size of the index
+};
+
+struct libentry {                // 32 bytes
+  uint16_t number;               // bank*LIB_PERBANK+patch
+  uint8_t used;                  // 0 if nothing has been saved here
+  uint8_t spare;
+  char name[LIB_NAMELEN];
+  uint32_t hash;                 // of the image
+  uint32_t offset;               // file offset of the image
+};
+
+struct libjournal {
+  uint32_t magic;
+  struct libentry entry;
+  uint8_t image[SYNTH_PARAMS];
+  uint32_t crc;                  // of everything above
+};
+
+SPIClass libspi(HSPI);
+File libfile;
+bool libready;                   // card and library file are usable
+struct libentry libcurrent;      // last entry browsed - loading it doesn't read the index again
+
+// library statistics
+uint16_t libreplayed;            // journals replayed at startup
+uint16_t libdiscarded;           // incomplete journals thrown away
+uint16_t libbadhash;             // loads refused because the image didn't match its hash
+
+// FNV-1a of a patch image
+uint32_t lib_hash(const uint8_t * image) {
+  uint32_t h=2166136261UL;
+  for (uint16_t i=0; i < SYNTH_PARAMS; ++i) {
+    h^=image[i];
+    h*=16777619UL;
+  }
+  return h;
+}
+
+uint32_t lib_crc32(const uint8_t * data, uint16_t len) {
+  uint32_t crc=0xFFFFFFFF;
+  for (uint16_t i=0; i < len; ++i) {
+    crc^=data[i];
+    for (uint8_t b=0; b < 8; ++b) crc=(crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+  }
+  return ~crc;
+}
+
+bool lib_writeat(File & f, uint32_t offset, const void * data, uint16_t len) {
+  return f.seek(offset) && (f.write((const uint8_t *)data,len) == len);
+}
+
+bool lib_readat(File & f, uint32_t offset, void * data, uint16_t len) {
+  return f.seek(offset) && (f.read((uint8_t *)data,len) == len);
+}
+
+// write a journalled entry and image into the library
+bool lib_apply(struct libjournal * j) {
+  bool ok=lib_writeat(libfile,j->entry.offset,j->image,SYNTH_PARAMS);
+  ok=ok && lib_writeat(libfile,LIB_INDEX+j->entry.number*sizeof(libentry),&j->entry,sizeof(libentry));
+  libfile.flush();
+  return ok;
+}
+
+// finish a save interrupted by a power cut or a failed library write - call with the library open
+// the journal is only removed once its entry is in the library, so returns false if a committed save is still pending
+bool lib_replay(void) {
+  static struct libjournal j;
+  uint32_t commit=0;
+  if (!SD.exists(LIB_JOURNAL)) return true;
+  File f=SD.open(LIB_JOURNAL,FILE_READ);
+  bool complete=f && (f.read((uint8_t *)&j,sizeof(j)) == sizeof(j)) && (f.read((uint8_t *)&commit,sizeof(commit)) == sizeof(commit));
+  if (f) f.close();
+  if (complete && (j.magic == LIB_JMAGIC) && (commit == LIB_COMMIT) && (j.entry.number < LIB_ENTRIES)
+      && (j.crc == lib_crc32((const uint8_t *)&j,sizeof(j)-sizeof(j.crc)))) {
+    if (!lib_apply(&j)) return false;  // leave it for the next try
+    ++libreplayed;
+  }
+  else ++libdiscarded;  // the save never committed - the library still has the old patch
+  SD.remove(LIB_JOURNAL);
+  return true;
+}
+
+// a new library - superblock and an empty index
+bool lib_create(void) {
+  uint8_t block[512];
+  struct libsuper super={LIB_MAGIC,LIB_VERSION,LIB_ENTRIES};
+  libfile=SD.open(LIB_FILE,FILE_WRITE);
+  if (!libfile) return false;
+  memset(block,0,sizeof(block));
+  memcpy(block,&super,sizeof(super));
+  bool ok=libfile.write(block,sizeof(block)) == sizeof(block);
+  memset(block,0,sizeof(block));
+  for (uint32_t i=0; ok && (i < LIB_ENTRIES*sizeof(libentry)); i+=sizeof(block)) ok=libfile.write(block,sizeof(block)) == sizeof(block);
+  libfile.close();
+  return ok;
+}
+
+// mount the card and open the library, creating it if there isn't one - call from setup()
+bool lib_begin(void) {
+  struct libsuper super;
+  libspi.begin(SD_SCLK,SD_MISO,SD_MOSI,SD_CS);
+  if (!SD.begin(SD_CS,libspi)) return false;
+  if (!SD.exists(LIB_FILE) && !lib_create()) return false;
+  libfile=SD.open(LIB_FILE,"r+");
+  if (!libfile) return false;
+  if (!lib_readat(libfile,0,&super,sizeof(super)) || (super.magic != LIB_MAGIC) || (super.version != LIB_VERSION)
+      || (super.entries != LIB_ENTRIES)) {
+    libfile.close();
+    return false;
+  }
+  lib_replay();
+  libready=true;
+  return true;
+}
+
+// read entry n's index record into libcurrent
+// returns false if there is no library or nothing saved there
+bool lib_browse(uint16_t n) {
+  memset(&libcurrent,0,sizeof(libcurrent));
+  if (!libready || (n >= LIB_ENTRIES)) return false;
+  if (!lib_readat(libfile,LIB_INDEX+n*sizeof(libentry),&libcurrent,sizeof(libcurrent))) return false;
+  return libcurrent.used && (libcurrent.number == n);
+}
+
+// read entry n's image
+bool lib_load(uint16_t n, uint8_t * image) {
+  if (!libcurrent.used || (libcurrent.number != n)) {
+    if (!lib_browse(n)) return false;
+  }
+  if (!lib_readat(libfile,libcurrent.offset,image,SYNTH_PARAMS)) return false;
+  if (lib_hash(image) != libcurrent.hash) {
+    ++libbadhash;
+    return false;
+  }
+  return true;
+}
+
+// save an image as entry n - replaces what was there
+bool lib_save(uint16_t n, const uint8_t * image, const char * name) {
+  static struct libjournal j;
+  uint32_t commit=LIB_COMMIT;
+  if (!libready || (n >= LIB_ENTRIES)) return false;
+  if (!lib_replay()) return false;  // a committed save that didn't make it into the library - don't overwrite its journal
+  bool replace=lib_browse(n);
+  memset(&j,0,sizeof(j));
+  j.magic=LIB_JMAGIC;
+  j.entry.number=n;
+  j.entry.used=1;
+  strncpy(j.entry.name,name,LIB_NAMELEN-1);
+  j.entry.hash=lib_hash(image);
+  j.entry.offset=replace ? libcurrent.offset : libfile.size();  // overwrite in place or append
+  memcpy(j.image,image,SYNTH_PARAMS);
+  j.crc=lib_crc32((const uint8_t *)&j,sizeof(j)-sizeof(j.crc));
+  File f=SD.open(LIB_JOURNAL,FILE_WRITE);
+  if (!f) return false;
+  bool ok=f.write((const uint8_t *)&j,sizeof(j)) == sizeof(j);
+  f.flush();
+  ok=ok && (f.write((const uint8_t *)&commit,sizeof(commit)) == sizeof(commit));  // the save is committed from here on
+  f.close();
+  if (!ok) {
+    SD.remove(LIB_JOURNAL);
+    return false;
+  }
+  ok=lib_apply(&j);
+  if (ok) {
+    SD.remove(LIB_JOURNAL);
+    libcurrent=j.entry;
+  }
+  return ok;  // if the library write failed the journal stays and is replayed before the next save or at startup
+}
+
+#endif // SDCARD
+
+#endif // SDLIBRARY_H_
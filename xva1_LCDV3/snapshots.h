@@ -0,0 +1,133 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+//
+// patch snapshots in the ESP32's NVS flash
+// snapshots are coded with patchcodec.h against the synth's init patch, which is read once on the first boot and kept in NVS
+// so every snapshot decodes against the same base. each snapshot is stored as
+//   base type, base checksum low, base checksum high, coded patch
+// a snapshot made before the init patch was known is coded against an all zero image instead
+
+#ifndef SNAPSHOTS_H_
+#define SNAPSHOTS_H_
+
+#include <Preferences.h>
+
+#define SNAP_NAMESPACE "xva1"
+#define SNAP_HEADER 3
+#define SNAP_BASEZERO 0     // base types
+#define SNAP_BASEINIT 1
+
+Preferences nvs;
+uint8_t initimage[SYNTH_PARAMS];  // the synth's init patch
+bool initknown;
+
+// snapshot statistics
+uint32_t snapbytes;         // coded size of the last snapshot saved or loaded
+uint32_t snapencodetime;    // us
+uint32_t snapdecodetime;
+
+// open NVS and get the init patch
+// returns false if it isn't known yet - it is kept the first time the user inits a patch, see snap_setinit(). asking the
+// synth for it at boot would replace the patch it is playing
+bool snap_begin(void) {
+  nvs.begin(SNAP_NAMESPACE,false);
+  initknown=nvs.getBytes("init",initimage,SYNTH_PARAMS) == SYNTH_PARAMS;
+  return initknown;
+}
+
+// keep the init patch as the snapshot base. only the first one is kept - snapshots already saved depend on it
+void snap_setinit(const uint8_t * image) {
+  if (initknown) return;
+  if (image != initimage) memcpy(initimage,image,SYNTH_PARAMS);
+  initknown=nvs.putBytes("init",initimage,SYNTH_PARAMS) == SYNTH_PARAMS;
+}
+
+const uint8_t * snap_base(uint8_t type) {
+  static const uint8_t zero[SYNTH_PARAMS]={0};
+  return (type == SNAP_BASEINIT) ? initimage : zero;
+}
+
+void snap_key(uint8_t n, char * key) {
+  sprintf(key,"snap%u",n);
+}
+
+// coded size of snapshot n, 0 if it is empty
+uint16_t snap_size(uint8_t n) {
+  char key[12];
+  snap_key(n,key);
+  return nvs.getBytesLength(key);
+}
+
+#define SNAP_MAXLEN (SNAP_HEADER+CODEC_MAXLEN)
+
+// code an image with its header into out, which must hold SNAP_MAXLEN bytes
+// returns the coded length
+uint16_t snap_encode(const uint8_t * image, uint8_t * out) {
+  uint8_t type=initknown ? SNAP_BASEINIT : SNAP_BASEZERO;
+  const uint8_t * base=snap_base(type);
+  uint16_t sum=patch_checksum(base);
+  out[0]=type;
+  out[1]=sum & 0xFF;
+  out[2]=sum >> 8;
+  uint32_t start=micros();
+  uint16_t len=SNAP_HEADER+codec_encode(image,base,&out[SNAP_HEADER]);
+  snapencodetime=micros()-start;
+  snapbytes=len;
+  return len;
+}
+
+// rebuild an image coded by snap_encode()
+bool snap_decode(const uint8_t * in, uint16_t len, uint8_t * image) {
+  if (len <= SNAP_HEADER) return false;
+  if ((in[0] == SNAP_BASEINIT) && !initknown) return false;
+  const uint8_t * base=snap_base(in[0]);
+  if (patch_checksum(base) != (in[1] | (in[2] << 8))) return false;  // not the base it was coded against
+  uint32_t start=micros();
+  bool ok=codec_decode(&in[SNAP_HEADER],len-SNAP_HEADER,base,image);
+  snapdecodetime=micros()-start;
+  snapbytes=len;
+  return ok;
+}
+
+bool snap_save(uint8_t n, const uint8_t * image) {
+  static uint8_t code[SNAP_MAXLEN];
+  char key[12];
+  if (n >= SNAP_COUNT) return false;
+  uint16_t len=snap_encode(image,code);
+  snap_key(n,key);
+  return nvs.putBytes(key,code,len) == len;
+}
+
+bool snap_load(uint8_t n, uint8_t * image) {
+  static uint8_t code[SNAP_MAXLEN];
+  char key[12];
+  if (n >= SNAP_COUNT) return false;
+  snap_key(n,key);
+  return snap_decode(code,nvs.getBytes(key,code,sizeof(code)),image);
+}
+
+#endif // SNAPSHOTS_H_
@@ -0,0 +1,328 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// non blocking command engine for the serial link to the XVA1 FPGA
+// every command is a transaction in a small queue. synth_poll() is called from loop() and steps the transaction at the head
+// of the queue through its states: send the command, wait for the acknowledgement, then collect the 512 byte dump a chunk at a time
+// each phase has a timeout. a timed out phase is retried a couple of times, then the transaction completes with SYNTH_TIMEOUT
+// so a missing or powered off synth no longer hangs the editor
+// a dump is collected in synthdump and only copied to its destination once all 512 bytes are in, so a load that times out
+// halfway leaves the parameter array as it was
+// everything the engine sends is bulk work to the scheduler in linksched.h. a transaction doesn't start and an upload doesn't
+// send its next frame while an interactive write is waiting for the link, and uploads are paced by the bulk budget.
+// writeq_flush() gets the link between upload frames - they are all 's' frames so it doesn't matter what order they land in
+// the TR_DUMP trace runs from the first 'd' until the dump is in or has timed out for good, retries included
+
+#ifndef SYNTHLINK_H_
+#define SYNTHLINK_H_
+
+#define SYNTH_PARAMS 512        // size of the XVA1 patch image returned by the 'd' command
+#define SYNTH_QUEUE 16          // max number of transactions waiting for the link
+#define SYNTH_ACK_TIMEOUT 100   // ms to wait for the acknowledgement byte of 'r', 'w' and 'i'
+#define SYNTH_DUMP_TIMEOUT 250  // ms to wait for a complete 512 byte dump - takes ~10ms at 500kbaud
+#define SYNTH_RETRIES 2         // number of times a timed out phase is resent before we give up
+#define SYNTH_DUMP_CHUNK 64     // max dump bytes read per synth_poll() call so the UI keeps running during a load
+
+extern uint8_t parameters[];  // the editor's copy of the synth parameters - default destination of a dump
+
+// commands - the order must match synthcmds[] below
+enum synthcmd {CMD_SET, CMD_DUMP, CMD_READ, CMD_WRITE, CMD_INIT, CMD_RECALL, CMD_UPLOAD};
+
+// transaction results passed to the completion callback
+enum synthresult {SYNTH_OK, SYNTH_TIMEOUT};
+
+// completion callback - cmd is the command that finished, result is one of synthresult
+typedef void (*synthcallback)(uint8_t cmd, uint8_t result);
+
+// protocol description of each command
+struct synthcmdinfo {
+  char code;        // command character sent to the synth
+  bool ack;         // synth replies with one acknowledgement byte
+  bool dump;        // command is followed by a 'd' dump of all parameters
+  uint16_t timeout; // ms allowed for the first reply phase
+};
+
+const struct synthcmdinfo synthcmds[] = {
+  // code,ack,dump,timeout
+  's',false,false,0,                 // set parameter - no reply
+  'd',false,true,SYNTH_DUMP_TIMEOUT, // dump all parameters
+  'r',true,true,SYNTH_ACK_TIMEOUT,   // read patch from memory slot, then dump it
+  'w',true,false,SYNTH_ACK_TIMEOUT,  // write patch to memory slot
+  'i',true,true,SYNTH_ACK_TIMEOUT,   // init patch, then dump it
+  'r',true,false,SYNTH_ACK_TIMEOUT,  // read patch from memory slot without the dump - we already have the image
+  's',false,false,0,                 // send a whole patch image as parameter frames - dest is the image
+};
+
+// arg of CMD_UPLOAD
+#define UPLOAD_ALL 0        // every parameter
+#define UPLOAD_EDITED 1     // only the ones in the changed set, the edits and changes made on the synth - see dirtyset.h
+
+struct synthtransaction {
+  uint8_t cmd;       // one of synthcmd
+  uint16_t arg;      // memory slot, parameter number or UPLOAD_ALL/UPLOAD_EDITED
+  uint8_t val;       // parameter value for CMD_SET
+  uint8_t * dest;    // where the dump goes, NULL throws it away. the image sent by CMD_UPLOAD
+  synthcallback done; // called when the transaction completes, can be NULL
+  unsigned long queued; // micros() when it was queued
+};
+
+// link states
+enum linkstate {LINK_IDLE, LINK_ACK, LINK_DUMP, LINK_UPLOAD};
+
+struct synthtransaction synthqueue[SYNTH_QUEUE];
+uint8_t synthhead;    // transaction in progress or next to start
+uint8_t synthcount;   // number of transactions in the queue
+uint8_t linkstate=LINK_IDLE;
+uint8_t synthtries;   // retries left for the current phase
+uint16_t dumpcount;   // dump bytes received or upload parameters sent so far
+uint8_t synthdump[SYNTH_PARAMS]; // the dump in progress
+unsigned long phasetime; // millis() when the current phase started
+
+// link statistics
+uint16_t synthtimeouts;  // phases that timed out
+uint16_t synthfailures;  // transactions that gave up
+uint16_t synthdropped;   // transactions refused because the queue was full
+bool synthwaiting;       // synth_wait() is running the link - nothing else will send, don't hold back for writes
+
+// send a parameter frame, returns the number of bytes sent
+// note that Rene's documentation says the 2 byte address threshold is >=255 but his UI code uses >=256
+uint8_t synth_sendset(uint16_t paramnumber,unsigned char val) {
+  Serial2.write('s');
+  if (paramnumber <256) {
+    Serial2.write((unsigned char)paramnumber);  // address
+    Serial2.write(val);  // data
+    return 3;
+  }
+  else {
+    Serial2.write(255);  // address low
+    Serial2.write((unsigned char)(paramnumber-256));  // address high
+    Serial2.write(val); // data
+    return 4;
+  }
+}
+
+// send the command bytes for a phase of the current transaction
+// dumponly - true when we are past the acknowledgement and only need to (re)send 'd'
+// whatever is waiting on the input is thrown away first - junk after an ack or the tail of a dump that timed out
+void synth_sendcmd(struct synthtransaction * t, bool dumponly) {
+  while (Serial2.available()) Serial2.read(); // dump any unread shit so it doesn't look like a reply
+  if (dumponly) {
+    Serial2.write('d');
+    sched_charge(LC_BULK,1);
+    return;
+  }
+  Serial2.write(synthcmds[t->cmd].code);
+  sched_charge(LC_BULK,1);
+  if ((t->cmd == CMD_READ) || (t->cmd == CMD_WRITE) || (t->cmd == CMD_RECALL)) {
+    Serial2.write((unsigned char)t->arg); // memory slot
+    sched_charge(LC_BULK,1);
+  }
+}
+
+// begin the reply phase of the current transaction
+void synth_phase(uint8_t state) {
+  if (state == LINK_DUMP) TRACE_BEGIN(TR_DUMP);
+  linkstate=state;
+  dumpcount=0;
+  phasetime=millis();
+  synthtries=SYNTH_RETRIES;
+}
+
+// finish the transaction at the head of the queue and start the next one
+// the transaction is removed before the callback runs so the callback can queue more work
+void synth_complete(uint8_t result) {
+  struct synthtransaction t=synthqueue[synthhead];
+  synthhead=(synthhead+1) % SYNTH_QUEUE;
+  --synthcount;
+  if (linkstate == LINK_DUMP) TRACE_END(TR_DUMP);
+  linkstate=LINK_IDLE;
+  if (result != SYNTH_OK) ++synthfailures;
+  if (t.cmd != CMD_SET) sched_done(LC_BULK,micros()-t.queued);
+  if (t.done) t.done(t.cmd,result);
+}
+
+// start the transaction at the head of the queue
+void synth_start(void) {
+  struct synthtransaction * t=&synthqueue[synthhead];
+  const struct synthcmdinfo * info=&synthcmds[t->cmd];
+  if (t->cmd == CMD_SET) {  // fire and forget - an edit that had to wait behind a transaction
+    sched_charge(LC_EDIT,synth_sendset(t->arg,t->val));
+    sched_done(LC_EDIT,micros()-t->queued);
+    synth_complete(SYNTH_OK);
+    return;
+  }
+  if (t->cmd == CMD_UPLOAD) {  // no reply, just a lot to send
+    synth_phase(LINK_UPLOAD);
+    return;
+  }
+  synth_sendcmd(t,false);
+  synth_phase(info->ack ? LINK_ACK : LINK_DUMP);
+}
+
+// add a transaction to the queue
+// returns false if the queue is full
+bool synth_queue(uint8_t cmd, uint16_t arg, uint8_t val, uint8_t * dest, synthcallback done) {
+  if (synthcount >= SYNTH_QUEUE) {
+    ++synthdropped;
+    return false;
+  }
+  struct synthtransaction * t=&synthqueue[(synthhead+synthcount) % SYNTH_QUEUE];
+  t->cmd=cmd;
+  t->arg=arg;
+  t->val=val;
+  t->dest=dest;
+  t->done=done;
+  t->queued=micros();
+  ++synthcount;
+  return true;
+}
+
+// true while a transaction is waiting for the synth or queued
+bool synth_busy(void) {
+  return synthcount != 0;
+}
+
+// number of transactions that can still be queued
+uint8_t synth_room(void) {
+  return SYNTH_QUEUE-synthcount;
+}
+
+// true when a parameter frame can go out now - nothing is waiting for a reply. during an upload frames can be mixed in
+bool synth_cansend(void) {
+  return (linkstate == LINK_IDLE) || (linkstate == LINK_UPLOAD);
+}
+
+// write a parameter value to the synth
+// goes out right away when the link is idle, otherwise it waits behind the transactions in the queue
+// returns the number of bytes sent, 0 if it was queued, -1 if the queue is full and nothing was done
+int8_t synth_set(uint16_t paramnumber,unsigned char val) {
+  if (!synth_busy()) return synth_sendset(paramnumber,val);
+  return synth_queue(CMD_SET,paramnumber,val,0,NULL) ? 0 : -1;
+}
+
+// cancel every transaction that would complete with callback done
+// waiting transactions are removed from the queue. the one in progress can't be pulled back from the synth so it runs to the end
+// to keep the link in step, but its dump is thrown away and its callback isn't called
+// returns the number of transactions cancelled
+uint8_t synth_cancel(synthcallback done) {
+  uint8_t cancelled=0;
+  uint8_t kept=0;
+  uint8_t first=0;
+  if (linkstate != LINK_IDLE) {  // leave the head in place
+    struct synthtransaction * t=&synthqueue[synthhead];
+    if (t->done == done) {
+      t->done=NULL;
+      t->dest=NULL;
+      ++cancelled;
+    }
+    first=kept=1;
+  }
+  for (uint8_t i=first; i < synthcount; ++i) {
+    struct synthtransaction * t=&synthqueue[(synthhead+i) % SYNTH_QUEUE];
+    if (t->done == done) {
+      ++cancelled;
+      continue;
+    }
+    synthqueue[(synthhead+kept) % SYNTH_QUEUE]=*t;
+    ++kept;
+  }
+  synthcount=kept;
+  return cancelled;
+}
+
+// a reply phase timed out - resend it or give up
+void synth_timeout(void) {
+  struct synthtransaction * t=&synthqueue[synthhead];
+  ++synthtimeouts;
+  if (synthtries == 0) {
+    synth_complete(SYNTH_TIMEOUT);
+    return;
+  }
+  --synthtries;
+  synth_sendcmd(t,linkstate == LINK_DUMP && synthcmds[t->cmd].ack); // after an ack only the dump is repeated
+  dumpcount=0;
+  phasetime=millis();
+}
+
+// run the link state machine - call this every pass of loop()
+void synth_poll(void) {
+  struct synthtransaction * t;
+  sched_refill();
+  if (linkstate == LINK_IDLE) {
+    if (synthcount == 0) return;
+    if (!synthwaiting && sched_interactive()) return;  // let the writes go first
+    synth_start();
+    if (linkstate == LINK_IDLE) return; // it was a set, next one starts on the next pass
+  }
+  t=&synthqueue[synthhead];
+  switch (linkstate) {
+    case LINK_ACK:
+      if (Serial2.available()) {
+        Serial2.read(); // should be 0, I don't check
+        if (synthcmds[t->cmd].dump) {
+          synth_sendcmd(t,true);
+          synth_phase(LINK_DUMP);
+        }
+        else synth_complete(SYNTH_OK);
+        return;
+      }
+      if ((millis() - phasetime) > synthcmds[t->cmd].timeout) synth_timeout();
+      break;
+    case LINK_DUMP:
+      for (int i=0; (i < SYNTH_DUMP_CHUNK) && Serial2.available(); ++i) {
+        synthdump[dumpcount++]=Serial2.read();
+        if (dumpcount >= SYNTH_PARAMS) {
+          if (t->dest) memcpy(t->dest,synthdump,SYNTH_PARAMS);
+          synth_complete(SYNTH_OK);
+          return;
+        }
+      }
+      if ((millis() - phasetime) > SYNTH_DUMP_TIMEOUT) synth_timeout();
+      break;
+    case LINK_UPLOAD:  // only as many frames as the bulk budget allows and the UART can take without blocking
+      while ((dumpcount < SYNTH_PARAMS) && (synthwaiting || !sched_interactive()) && sched_ready(LC_BULK,LINK_MAXFRAME)
+          && (Serial2.availableForWrite() >= 5)) {
+        if (t->arg == UPLOAD_EDITED) {  // skip to the next parameter that differs from the base patch
+          dumpcount=pset_next(&changed,dumpcount);
+          if (dumpcount >= SYNTH_PARAMS) break;
+        }
+        sched_charge(LC_BULK,synth_sendset(dumpcount,t->dest[dumpcount]));
+        ++dumpcount;
+      }
+      if (dumpcount >= SYNTH_PARAMS) synth_complete(SYNTH_OK);
+      break;
+  }
+}
+
+// run the link until the queue is empty - only for setup() where there is nothing else to do
+// bounded by the timeouts and retries of whatever is queued
+void synth_wait(void) {
+  synthwaiting=true;
+  while (synth_busy()) synth_poll();
+  synthwaiting=false;
+}
+
+#endif // SYNTHLINK_H_
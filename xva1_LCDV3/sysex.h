@@ -0,0 +1,305 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+//
+// SysEx export and import of patches over the MIDI port
+// a patch goes out as 8 messages of 64 bytes each, packed 7 bits to a byte:
+//   F0 7D 58 01 slot chunk <74 packed bytes> checksum F7
+// slot is the XVA1 memory slot 0-127. the patch being edited travels the same way as type 04 with slot 0 - every
+// slot number is a real slot so none can stand for it. checksum is the 7 bit sum of the packed bytes
+// the host asks for a patch with F0 7D 58 10 slot F7, for the whole bank with F0 7D 58 11 F7 or for the patch being
+// edited with F0 7D 58 12 F7
+// exports only write as much as fits in the UART's transmit buffer on each pass of loop() so a bank dump streams at the
+// full MIDI rate without stalling the UI. slots that aren't in the patch cache are read from the synth with cache_readslot(),
+// which puts the loaded slot and its edits back after each read - refused if the synth isn't on a slot it can put back
+// imports are paced by the host: every chunk is answered with F0 7D 58 02 slot chunk F7, or 03 instead of 02 if it was refused
+// (05 and 06 for the patch being edited). the last chunk is answered once the patch has been sent to the synth and written
+// to its slot. it is refused while a save is waiting - the save has to go out with the patch it was asked for
+
+#ifndef SYSEX_H_
+#define SYSEX_H_
+
+#define SX_ID 0x7D          // non commercial manufacturer ID
+#define SX_DEVICE 0x58      // 'X' for XVA1
+#define SX_PATCH 0x01       // one chunk of a memory slot
+#define SX_ACK 0x02         // chunk received
+#define SX_NAK 0x03         // chunk refused
+#define SX_EDIT 0x04        // one chunk of the patch being edited
+#define SX_EDITACK 0x05     // and its replies
+#define SX_EDITNAK 0x06
+#define SX_REQPATCH 0x10    // host asks for one patch
+#define SX_REQBANK 0x11     // host asks for all slots
+#define SX_REQEDIT 0x12     // host asks for the patch being edited
+#define SX_CHUNK 64         // patch bytes per message
+#define SX_CHUNKS (SYNTH_PARAMS/SX_CHUNK)
+#define SX_PACKED 74        // SX_CHUNK bytes packed 7 bits to a byte
+#define SX_MSGLEN (SX_PACKED+8) // F0, header, packed data, checksum and F7
+#define SX_TIMEOUT 2000     // ms allowed between the chunks of an import before it is abandoned
+
+enum sysexstate {SX_IDLE, SX_NEXT, SX_SEND, SX_FETCH, SX_RECEIVE, SX_APPLY};
+
+// results returned by sysex_poll() so the UI can report them
+enum sysexresult {SX_NONE, SX_EXPORTED, SX_IMPORTED, SX_FAILED, SX_REFUSED, SX_SAVING};
+
+extern bool savepending;    // a patch save is waiting for the edits ahead of it - see writepatch()
+
+uint8_t sysexstate=SX_IDLE;
+bool sxedit;                // the transfer is the patch being edited, not a slot
+uint8_t sxslot;             // slot being sent or received
+uint8_t sxlastslot;         // last slot of an export
+uint8_t sxchunk;            // next chunk to send or receive
+unsigned long sxtime;       // millis() of the last chunk received
+uint8_t sxresult=SX_NONE;
+uint8_t sysexfill[SYNTH_PARAMS]; // the image being exported and imported patches are assembled here
+
+// SysEx statistics
+uint32_t sysexsent;         // chunks sent
+uint32_t sysexreceived;     // chunks received
+uint16_t sysexbad;          // chunks refused
+uint16_t sysexpatches;      // patches sent
+
+// pack n bytes 7 bits to a byte - each group of up to 7 bytes is preceded by a byte holding their top bits
+// returns the packed length
+uint8_t sysex_pack(const uint8_t * src, uint8_t n, uint8_t * dst) {
+  uint8_t len=0;
+  for (uint8_t i=0; i < n; i+=7) {
+    uint8_t msbs=len++;
+    dst[msbs]=0;
+    for (uint8_t j=0; (j < 7) && (i+j < n); ++j) {
+      if (src[i+j] & 0x80) dst[msbs] |= 1 << j;
+      dst[len++]=src[i+j] & 0x7F;
+    }
+  }
+  return len;
+}
+
+// reverse of sysex_pack, returns the unpacked length
+uint8_t sysex_unpack(const uint8_t * src, uint8_t n, uint8_t * dst) {
+  uint8_t len=0;
+  for (uint8_t i=0; i < n; i+=8) {
+    uint8_t msbs=src[i];
+    for (uint8_t j=0; (j < 7) && (i+j+1 < n); ++j) {
+      dst[len++]=src[i+j+1] | ((msbs >> j) & 1) << 7;
+    }
+  }
+  return len;
+}
+
+// short reply to the host - ack or nak a chunk of a slot, or of the patch being edited
+void sysex_reply(bool ack, bool edit, uint8_t slot, uint8_t chunk) {
+  uint8_t type=edit ? (ack ? SX_EDITACK : SX_EDITNAK) : (ack ? SX_ACK : SX_NAK);
+  uint8_t msg[]={0xF0,SX_ID,SX_DEVICE,type,(uint8_t)(edit ? 0 : slot),chunk,0xF7};
+  Serial1.write(msg,sizeof(msg));
+}
+
+void sysex_sendchunk(void) {
+  uint8_t msg[SX_MSGLEN];
+  uint8_t len=0, sum=0;
+  msg[len++]=0xF0;
+  msg[len++]=SX_ID;
+  msg[len++]=SX_DEVICE;
+  msg[len++]=sxedit ? SX_EDIT : SX_PATCH;
+  msg[len++]=sxedit ? 0 : sxslot;
+  msg[len++]=sxchunk;
+  uint8_t packed=sysex_pack(sysexfill+sxchunk*SX_CHUNK,SX_CHUNK,&msg[len]);
+  for (uint8_t i=0; i < packed; ++i) sum+=msg[len+i];
+  len+=packed;
+  msg[len++]=sum & 0x7F;
+  msg[len++]=0xF7;
+  Serial1.write(msg,len);
+  ++sxchunk;
+  ++sysexsent;
+}
+
+void sysex_finish(uint8_t result) {
+  sysexstate=SX_IDLE;
+  sxresult=result;
+}
+
+// a slot read for an export finished
+void sysex_fetched(uint8_t, uint8_t result) {
+  if (sysexstate != SX_FETCH) return;
+  if (result != SYNTH_OK) {
+    sysex_finish(SX_FAILED);
+    return;
+  }
+  cache_store(sxslot,sysexfill);
+  sxchunk=0;
+  sysexstate=SX_SEND;
+}
+
+// find the image of sxslot and start sending it - from sysex_poll() once the last slot read has put the synth's patch back
+// the image is copied into sysexfill first so edits, loads and cache replacements during the export can't change it
+void sysex_nextimage(void) {
+  sxchunk=0;
+  if (sxedit) {
+    memcpy(sysexfill,parameters,SYNTH_PARAMS);
+    sysexstate=SX_SEND;
+    return;
+  }
+  struct cacheentry * e=cache_use(sxslot);
+  if (e != NULL) {
+    memcpy(sysexfill,e->image,SYNTH_PARAMS);
+    sysexstate=SX_SEND;
+    return;
+  }
+  if (!cache_canread()) {  // reading the slot would lose the synth's patch
+    sysex_reply(false,false,sxslot,0);
+    sysex_finish(SX_REFUSED);
+    return;
+  }
+  sysexstate=SX_FETCH;
+  if (!cache_readslot(sxslot,sysexfill,sysex_fetched)) sysex_finish(SX_FAILED);
+}
+
+// start sending slots first to last, or the patch being edited
+void sysex_export(bool edit, uint8_t first, uint8_t last) {
+  if (sysexstate != SX_IDLE) {
+    sysex_reply(false,edit,first,0);
+    return;
+  }
+  sxedit=edit;
+  sxslot=first;
+  sxlastslot=last;
+  sysexstate=SX_NEXT;
+}
+
+// an imported patch has been uploaded to the synth, and written to its slot if it has one
+void sysex_applied(uint8_t cmd, uint8_t result) {
+  if (sysexstate != SX_APPLY) return;
+  if (result != SYNTH_OK) {
+    synth_cancel(sysex_applied);  // the write of a patch the synth didn't get
+    sysex_reply(false,sxedit,sxslot,SX_CHUNKS-1);
+    sysex_finish(SX_FAILED);
+    return;
+  }
+  if (cmd == CMD_UPLOAD) {
+    if (!sxedit) return;  // the write follows
+    loadedslot=-1;  // no longer what is in any slot
+    edit_newbase(EDIT_NOBASE);
+    sysex_reply(true,true,0,SX_CHUNKS-1);
+    sysex_finish(SX_IMPORTED);
+    return;
+  }
+  cache_store(sxslot,parameters);
+  loadedslot=sxslot;
+  edit_newbase(sxslot);
+  sysex_reply(true,false,sxslot,SX_CHUNKS-1);
+  sysex_finish(SX_IMPORTED);
+}
+
+// a chunk of a patch from the host - edit is true for the patch being edited, slot is ignored then
+void sysex_chunk(bool edit, uint8_t slot, uint8_t chunk, const uint8_t * data, uint8_t len) {
+  uint8_t sum=0;
+  if (edit) slot=0;
+  for (uint8_t i=0; i < len; ++i) sum+=data[i];
+  bool next=(sysexstate == SX_RECEIVE) && (edit == sxedit) && (slot == sxslot) && (chunk == sxchunk);
+  bool first=(sysexstate == SX_IDLE) || (sysexstate == SX_RECEIVE);
+  if ((len != SX_PACKED) || ((sum & 0x7F) != data[len]) || (chunk >= SX_CHUNKS) || (slot >= NUM_SLOTS)
+      || !(next || (first && (chunk == 0)))) {
+    ++sysexbad;
+    sysex_reply(false,edit,slot,chunk);
+    return;
+  }
+  sysex_unpack(data,len,sysexfill+chunk*SX_CHUNK);
+  ++sysexreceived;
+  sxedit=edit;
+  sxslot=slot;
+  sxchunk=chunk+1;
+  sxtime=millis();
+  if (sxchunk < SX_CHUNKS) {
+    sysexstate=SX_RECEIVE;
+    sysex_reply(true,edit,slot,chunk);
+    return;
+  }
+  if (savepending) {  // like loadpatch() - the save needs the patch and edits it was asked for
+    sysex_reply(false,edit,slot,chunk);
+    sysex_finish(SX_SAVING);
+    return;
+  }
+  writeq_clear();  // edits still waiting for the link belong to the patch being replaced
+  memcpy(parameters,sysexfill,SYNTH_PARAMS);
+  sysexstate=SX_APPLY;  // acked when the synth has it
+  bool queued=synth_queue(CMD_UPLOAD,UPLOAD_ALL,0,parameters,sysex_applied);
+  if (queued && !edit) queued=synth_queue(CMD_WRITE,slot,0,0,sysex_applied);
+  if (!queued) {
+    sysex_reply(false,edit,slot,chunk);
+    sysex_finish(SX_FAILED);
+  }
+}
+
+// handle a SysEx message from the parser - call when the MIDI parser delivers MIDI_SYSEX
+void sysex_receive(void) {
+  if ((sysexlen < 3) || (sysexbuf[0] != SX_ID) || (sysexbuf[1] != SX_DEVICE)) return;  // not for us
+  switch (sysexbuf[2]) {
+    case SX_REQPATCH:
+      if (sysexlen >= 4) sysex_export(false,sysexbuf[3],sysexbuf[3]);
+      break;
+    case SX_REQBANK:
+      sysex_export(false,0,NUM_SLOTS-1);
+      break;
+    case SX_REQEDIT:
+      sysex_export(true,0,0);
+      break;
+    case SX_PATCH:
+    case SX_EDIT:
+      if (sysexlen >= 6) sysex_chunk(sysexbuf[2] == SX_EDIT,sysexbuf[3],sysexbuf[4],&sysexbuf[5],sysexlen-6);
+      break;
+  }
+}
+
+// true while a transfer is running
+bool sysex_busy(void) {
+  return sysexstate != SX_IDLE;
+}
+
+// run transfers - call every pass of loop()
+// returns one of sysexresult when a transfer ends
+uint8_t sysex_poll(void) {
+  switch (sysexstate) {
+    case SX_NEXT:
+      if (!slotreading && (synth_room() >= 3)) sysex_nextimage();
+      break;
+    case SX_SEND:
+      while ((sxchunk < SX_CHUNKS) && (Serial1.availableForWrite() >= SX_MSGLEN)) sysex_sendchunk();
+      if (sxchunk < SX_CHUNKS) break;
+      ++sysexpatches;
+      if (sxslot >= sxlastslot) sysex_finish(SX_EXPORTED);
+      else {
+        ++sxslot;
+        sysexstate=SX_NEXT;
+      }
+      break;
+    case SX_RECEIVE:
+      if ((millis() - sxtime) > SX_TIMEOUT) sysex_finish(SX_FAILED);
+      break;
+  }
+  uint8_t result=sxresult;
+  sxresult=SX_NONE;
+  return result;
+}
+
+#endif // SYSEX_H_
@@ -0,0 +1,128 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// hot path tracing
+// TRACE_BEGIN(tag)/TRACE_END(tag) put an event stamped with the CPU cycle counter in a RAM ring. that's a register read and
+// two stores so it stays compiled in - define NOTRACE to take it out. interrupt handlers use TRACE_ISR_BEGIN/TRACE_ISR_END
+// which have their own ring so an ISR can never land in the middle of an event loop() is writing
+// type "trace" on the debug serial port to get a dump of both rings, tools/tracedecode.py turns a dump into per stage
+// latency histograms. the rings only hold the last TRACE_SIZE events each so dump right after doing what you want to see
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#define TRACE_SIZE 512       // events per ring, power of 2. 8 bytes each
+
+// stages we trace - add new ones before TR_COUNT and give them a name below
+enum tracetag {TR_LOOP, TR_ENCTIMER, TR_DRAWSUBMENU, TR_SETPARAMETER, TR_DUMP, TR_SCROLLMENUS, TR_LCDUPDATE,
+  TR_ADC, TR_LINK, TR_WRITEQ, TR_MIDI, TR_COUNT};
+
+const char * const tracenames[TR_COUNT] = {
+  "loop", "encTimer", "drawsubmenu", "setparameter", "dump", "scrollmenus", "lcdupdate",
+  "potTimer", "synth_poll", "writeq_flush", "midi",
+};
+
+enum tracering {TRACE_LOOP, TRACE_ISR, TRACE_RINGS};
+
+struct traceevent {
+  uint32_t cycles;
+  uint8_t tag;
+  uint8_t end;      // 0 begin, 1 end
+};
+
+struct traceevent traces[TRACE_RINGS][TRACE_SIZE];
+volatile uint32_t tracehead[TRACE_RINGS];  // next event in each ring, free running
+volatile bool tracefrozen;                 // set while a dump reads the rings
+
+// CPU cycle counter - wraps every 17s at 240MHz, plenty for the intervals in the rings
+static inline uint32_t ICACHE_RAM_ATTR trace_cycles(void) {
+#if defined(ARDUINO_ARCH_ESP32)
+  uint32_t c;
+  __asm__ __volatile__("rsr %0, ccount" : "=a"(c));
+  return c;
+#elif defined(__x86_64__) || defined(__i386__)
+  return (uint32_t)__builtin_ia32_rdtsc();
+#else
+  return micros();
+#endif
+}
+
+static inline void ICACHE_RAM_ATTR trace_event(uint8_t ring, uint8_t tag, uint8_t end) {
+  if (tracefrozen) return;
+  uint32_t h=tracehead[ring];
+  struct traceevent * e=&traces[ring][h & (TRACE_SIZE-1)];
+  e->cycles=trace_cycles();
+  e->tag=tag;
+  e->end=end;
+  tracehead[ring]=h+1;
+}
+
+#ifdef NOTRACE
+#define TRACE_BEGIN(tag)
+#define TRACE_END(tag)
+#define TRACE_ISR_BEGIN(tag)
+#define TRACE_ISR_END(tag)
+#else
+#define TRACE_BEGIN(tag) trace_event(TRACE_LOOP,tag,0)
+#define TRACE_END(tag) trace_event(TRACE_LOOP,tag,1)
+#define TRACE_ISR_BEGIN(tag) trace_event(TRACE_ISR,tag,0)
+#define TRACE_ISR_END(tag) trace_event(TRACE_ISR,tag,1)
+#endif
+
+// cycles per us, counted over a ms of micros()
+// the host build's micros() is the bench's virtual clock so it asks the host for the counter's rate instead
+uint32_t trace_mhz(void) {
+#if !defined(ARDUINO_ARCH_ESP32) && (defined(__x86_64__) || defined(__i386__))
+  return hal_cyclemhz();
+#else
+  unsigned long start=micros();
+  while (micros() == start);  // line up with a tick
+  start=micros();
+  uint32_t c=trace_cycles();
+  while ((micros() - start) < 1000);
+  return (trace_cycles() - c + 500)/1000;
+#endif
+}
+
+// print both rings, oldest event first, and empty them
+// one line per event: ring (L loop, I interrupt), cycle count in hex, B or E, stage name
+void trace_dump(Print & out) {
+  tracefrozen=true;
+  out.printf("trace mhz %u size %u\n",trace_mhz(),TRACE_SIZE);
+  for (uint8_t ring=0; ring < TRACE_RINGS; ++ring) {
+    uint32_t head=tracehead[ring];
+    uint32_t count=(head < TRACE_SIZE) ? head : TRACE_SIZE;
+    for (uint32_t i=head-count; i != head; ++i) {
+      struct traceevent * e=&traces[ring][i & (TRACE_SIZE-1)];
+      out.printf("%c %08x %c %s\n",ring == TRACE_LOOP ? 'L' : 'I',e->cycles,e->end ? 'E' : 'B',e->tag < TR_COUNT ? tracenames[e->tag] : "?");
+    }
+    tracehead[ring]=0;
+  }
+  out.printf("trace end\n");
+  tracefrozen=false;
+}
+
+#endif // TRACE_H_
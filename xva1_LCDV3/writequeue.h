@@ -0,0 +1,205 @@
+// Copyright 2020 Rich Heslip
+//
+// Author: Rich Heslip
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// See http://creativecommons.org/licenses/MIT/ for more information.
+//
+// -----------------------------------------------------------------------------
+//
+// outbound parameter write queue
+// every edit goes in here instead of straight out the serial port. the queue is keyed by parameter number - a new value for
+// a parameter that is already waiting replaces the old value in place, so a fast encoder sweep sends one frame per parameter
+// instead of one per encoder tick whenever the link is behind
+// each write has a class from linksched.h - encoder edits, MIDI remote or pot. writeq_flush() is called from loop() and sends
+// the oldest write of the highest class that has budget, and so on while there is budget and room in the UART. a value
+// for a parameter that is already waiting in a lower class moves it up to the higher class
+// entries are kept oldest first. the queue is small so taking one out of the middle is a short memmove
+// when the queue is full and the link queue can't take its oldest write either, a new write waits outside the queue in a
+// set per class with its value, and moves in as soon as an entry leaves - a parameter's last value is never lost
+
+#ifndef WRITEQUEUE_H_
+#define WRITEQUEUE_H_
+
+#define WRITEQ_SIZE 32      // max number of different parameters waiting to go out
+
+struct writeentry {
+  uint16_t param;  // parameter number
+  uint8_t val;     // latest value
+  uint8_t cls;     // linkclass
+  unsigned long queued;  // micros() when the first value was queued
+};
+
+struct writeentry writeq[WRITEQ_SIZE];
+uint8_t writeqcount;   // number of entries waiting
+unsigned long writeqputtime;  // millis() of the last writeq_put()
+
+// write queue statistics
+uint32_t writeqqueued;     // writes handed to the queue
+uint32_t writeqcoalesced;  // writes that replaced a value already waiting
+uint32_t writeqsent;       // frames actually sent to the synth
+uint32_t writeqdeferred;   // writes that waited outside the queue because it and the link queue were both full
+
+struct paramset writeqover[LC_BULK];  // parameters waiting outside the queue, by class
+uint8_t writeqoverval[PSET_PARAMS];   // their values
+uint16_t writeqovercount;
+
+// the class a parameter is waiting outside the queue in, -1 if it isn't
+int8_t writeq_overclass(uint16_t param) {
+  if (writeqovercount == 0) return -1;
+  for (uint8_t cls=0; cls < LC_BULK; ++cls) {
+    if (pset_test(&writeqover[cls],param)) return cls;
+  }
+  return -1;
+}
+
+// add an entry at the end of the queue - there has to be room
+void writeq_append(uint16_t param, uint8_t val, uint8_t cls) {
+  struct writeentry * e=&writeq[writeqcount];
+  e->param=param;
+  e->val=val;
+  e->cls=cls;
+  e->queued=micros();
+  ++linkbudgets[cls].waiting;
+  ++writeqcount;
+}
+
+// true if a write of param is waiting
+bool writeq_has(uint16_t param) {
+  for (uint8_t i=0; i < writeqcount; ++i) {
+    if (writeq[i].param == param) return true;
+  }
+  return writeq_overclass(param) >= 0;
+}
+
+// take entry i out of the queue, and move the best write waiting outside into the room it leaves
+void writeq_remove(uint8_t i) {
+  --linkbudgets[writeq[i].cls].waiting;
+  --writeqcount;
+  memmove(&writeq[i],&writeq[i+1],(writeqcount-i)*sizeof(struct writeentry));
+  if (writeqovercount == 0) return;
+  for (uint8_t cls=0; cls < LC_BULK; ++cls) {
+    uint16_t p=pset_next(&writeqover[cls],0);
+    if (p >= PSET_PARAMS) continue;
+    pset_clear(&writeqover[cls],p);
+    --writeqovercount;
+    writeq_append(p,writeqoverval[p],cls);
+    return;
+  }
+}
+
+// send entry i and take it out of the queue
+// the frame goes straight out when the link can take it, otherwise it waits behind the synth transactions in progress
+// returns false if the link queue is full - the entry stays for the next try
+bool writeq_send(uint8_t i) {
+  struct writeentry * e=&writeq[i];
+  int8_t bytes=(synth_cansend() && !linkheld) ? synth_sendset(e->param,e->val) : synth_set(e->param,e->val);  // held ones wait behind the bulk work
+  if (bytes < 0) return false;
+  if (bytes) {  // a queued one is counted by the link engine when it goes out
+    sched_charge(e->cls,bytes);
+    sched_done(e->cls,micros()-e->queued);
+  }
+  writeq_remove(i);
+  ++writeqsent;
+  return true;
+}
+
+// queue a parameter write - last value wins
+// cls is the linkclass of whoever made the change
+void writeq_put(uint16_t param, uint8_t val, uint8_t cls) {
+  ++writeqqueued;
+  writeqputtime=millis();
+  for (uint8_t i=0; i < writeqcount; ++i) {
+    struct writeentry * e=&writeq[i];
+    if (e->param == param) {
+      e->val=val;  // replace the pending value, keep its place in the queue
+      if (cls < e->cls) {  // higher priority
+        --linkbudgets[e->cls].waiting;
+        ++linkbudgets[cls].waiting;
+        e->cls=cls;
+      }
+      ++writeqcoalesced;
+      return;
+    }
+  }
+  int8_t over=writeq_overclass(param);
+  if (over >= 0) {  // already waiting outside the queue - same as above
+    writeqoverval[param]=val;
+    if (cls < over) {
+      pset_clear(&writeqover[over],param);
+      pset_set(&writeqover[cls],param);
+    }
+    ++writeqcoalesced;
+    return;
+  }
+  if ((writeqcount >= WRITEQ_SIZE) && !writeq_send(0)) {  // full - make room by sending the oldest now
+    pset_set(&writeqover[cls],param);  // nowhere for it to go - it waits for the next entry to leave
+    writeqoverval[param]=val;
+    ++writeqovercount;
+    ++writeqdeferred;
+    return;
+  }
+  writeq_append(param,val,cls);
+}
+
+// send what the budgets allow - call this every pass of loop()
+// waits while a synth command is waiting for its reply so the frames don't get mixed up with it, and while writes are held
+void writeq_flush(void) {
+  if ((writeqcount == 0) || linkheld || !synth_cansend()) return;
+  sched_refill();
+  while ((writeqcount != 0) && (Serial2.availableForWrite() >= LINK_MAXFRAME)) {
+    int8_t next=-1;
+    for (uint8_t cls=0; (cls < LC_BULK) && (next < 0); ++cls) {  // oldest write of the best class that can go
+      if (!linkbudgets[cls].waiting || !sched_ready(cls,LINK_MAXFRAME)) continue;
+      for (uint8_t i=0; i < writeqcount; ++i) {
+        if (writeq[i].cls == cls) {
+          next=i;
+          break;
+        }
+      }
+    }
+    if ((next < 0) || !writeq_send(next)) return;
+  }
+}
+
+// send everything that is waiting, or as much as the link queue has room for - frames that can't go out now wait in it
+// behind the transaction in progress. reserve entries of it are left free for the caller
+// returns true once nothing is waiting. used before a patch save so the saved patch has all the edits
+bool writeq_flushall(uint8_t reserve) {
+  while ((writeqcount != 0) && (synth_cansend() || (synth_room() > reserve)) && writeq_send(0));
+  return writeqcount == 0;
+}
+
+// throw away everything that is waiting
+// used before a patch load or init - the edits belong to the patch being replaced
+void writeq_clear(void) {
+  for (uint8_t i=0; i < writeqcount; ++i) --linkbudgets[writeq[i].cls].waiting;
+  writeqcount=0;
+  for (uint8_t cls=0; cls < LC_BULK; ++cls) pset_clearall(&writeqover[cls]);
+  writeqovercount=0;
+}
+
+// print the write queue counters - what merging writes saved
+void writeq_report(Print & out) {
+  out.printf("writes %u, merged %u, frames sent %u, deferred %u, waiting %u\n",writeqqueued,writeqcoalesced,writeqsent,
+             writeqdeferred,writeqcount+writeqovercount);
+}
+
+#endif // WRITEQUEUE_H_
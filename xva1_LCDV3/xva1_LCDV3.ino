@@ -46,18 +46,43 @@
 //#include <BLE2902.h>
 //#include <pgmspace.h>
 #include <LiquidCrystal.h>
+//#define SDCARD  // patch library on an SD card - see sdlibrary.h and the SD pins in io.h
+//#define CODEC_BENCHMARK  // reads the first 32 memory slots at startup and prints patch codec results on the serial port
+//#define PARAMPOTS  // pots on the 4 parameter fields as well as the encoders - see P1POT..P4POT in io.h
+#include "trace.h"
 #include "menusystem.h"  
+#include "linksched.h"
+#include "dirtyset.h"
+#include "synthlink.h"
+#include "writequeue.h"
+#include "patchcache.h"
+#include "lcdbuffer.h"
+#include "potscan.h"
+#include "midiparser.h"
+#include "midiremote.h"
+#include "sysex.h"
+#include "patchcodec.h"
+#include "snapshots.h"
+#include "bootstate.h"
+#include "paramsync.h"
 #include "MIDI.h"
 #include "io.h"
-#include "Clickencoder.h"
+#include "sdlibrary.h"
+#include "ClickEncoder.h"
 #include <strings.h>
 
 #define DEBUG // enables serial out - should be disabled unless needed because I used the serial pins for encoder buttons 1&2- does strange things to the menus
 
 
 // sample interrupt timer defs
-#define ENC_TIMER_MICROS 1000 // 1khz for encoder
+#if ENC_EDGE_INTERRUPTS
+#define ENC_TIMER_MICROS 1000 // 1khz - A/B are decoded by pin change interrupts, the timer only does buttons
+#else
+#define ENC_TIMER_MICROS 500 // 2khz for encoders - fast spins don't skip steps
+#endif
 hw_timer_t * timer1 = NULL;
+hw_timer_t * timer2 = NULL;  // LCD output timer, rate is LCD_TIMER_MICROS in lcdasync.h
+hw_timer_t * timer0 = NULL;  // pot sampling timer, rate is POT_TIMER_MICROS in potscan.h
 
 
 // MIDI stuff
@@ -68,7 +93,9 @@ long midimessagetime;
 
 // create LCD display device
 // RS,E,D4,D5,D6,D7
-LiquidCrystal lcd(23, 33, 25, 15, 18, 19);
+LiquidCrystal lcd(LCD_RS, LCD_E, LCD_D4, LCD_D5, LCD_D6, LCD_D7); // only used to initialize the LCD
+LCDAsync lcdout(LCD_RS, LCD_E, LCD_D4, LCD_D5, LCD_D6, LCD_D7);   // timer interrupt driven output
+LCDBuffer lcdbuf(lcdout);  // all drawing goes thru the frame buffer, lcdbuf.update() sends the changes to the LCD
 
 // encoders 
 ClickEncoder menuEncoder(ENC_A,ENC_B,ENC_SW,4); // divide by 4 works best with this encoder
@@ -76,18 +103,15 @@ ClickEncoder P1Encoder(P1ENC_A,P1ENC_B,P1_SW,4); // switch is hooked to RXD0 - h
 ClickEncoder P2Encoder(P2ENC_A,P2ENC_B,P2_SW,4); 
 ClickEncoder P3Encoder(P3ENC_A,P3ENC_B,P3_SW,4); 
 ClickEncoder P4Encoder(P4ENC_A,P4ENC_B,P4_SW,4); 
+ClickEncoder * encoders[] = {&menuEncoder,&P1Encoder,&P2Encoder,&P3Encoder,&P4Encoder};
+#define NUM_ENCODERS (sizeof(encoders)/sizeof(encoders[0]))
 
-// ADC readings
-#define ADC_RANGE 4096  // 12 bit ADC
-#define CV_AVG 8     // number of readings to average readings over - 8 is max to avoid overflowing 16 bit int
-#define CV_SCALE 16  // A/D scale factor for parameter values
-
-// volume pot stuff
-#define VOLUME_LOCK 1000 // we lock the volume pot after this time (ms) to avoid audio crackles
-#define VOLUME_THRESHOLD 5 // volume change required to unlock
-uint16_t volume=0;
-bool volume_locked;
-long volumetimer;
+// pots - sampled in the background by potscan.h, loop() only sees them when they move
+int8_t volumepot;    // pot channel of the volume pot
+#ifdef PARAMPOTS
+const uint8_t parampotpins[4]={P1POT,P2POT,P3POT,P4POT};
+int8_t parampots[4]; // pot channels of the parameter field pots
+#endif
 
 // array that holds 512 synth parameters plus some internal parameters above that -FPGA memory read slot,write slot, dummy
 // param 0 is not used in the XFM2 or XVA1
@@ -95,104 +119,113 @@ uint8_t parameters[NUMPARAMS]; // xva1/xfm2 parameters plus a few extras for edi
 
 // change a parameter on the FPGA synth
 // write data from the parameter array which is what the menus modify
-// note that Rene's documentation says the 2 byte address threshold is >=255 but his UI code uses >=256
+// the write is queued in writequeue.h - repeated writes of the same parameter are merged before they go out
+// edits from the encoders have the highest priority on the link
 
 void setparameter(uint16_t paramnumber) {
-  Serial2.write('s');
-  if (paramnumber <256) {  
-    Serial2.write((unsigned char)paramnumber);  // address
-    Serial2.write(parameters[paramnumber]);  // data
-  }
-  else {
-    Serial2.write(255);  // address low
-    Serial2.write((unsigned char)(paramnumber-256));  // address high
-    Serial2.write(parameters[paramnumber]); // data
-  }
+  TRACE_BEGIN(TR_SETPARAMETER);
+  edit_mark(paramnumber);
+  writeq_put(paramnumber,parameters[paramnumber],LC_EDIT);
+  TRACE_END(TR_SETPARAMETER);
 }
 
 // write a parameter to the FPGA synth
 // same as above but the value is passed as an argument
+// cls is the link class of the source of the change - see linksched.h
 
-void writeparameter(uint16_t paramnumber,unsigned char val) {
-  Serial2.write('s');
-  if (paramnumber <256) {  
-    Serial2.write((unsigned char)paramnumber);  // address
-    Serial2.write(val);  // data
-  }
-  else {
-    Serial2.write(255);  // address low
-    Serial2.write((unsigned char)(paramnumber-256));  // address high
-    Serial2.write(val); // data
-  }
+void writeparameter(uint16_t paramnumber,unsigned char val,uint8_t cls) {
+  writeq_put(paramnumber,val,cls);
 }
 
+// the synth commands below are queued on the link engine in synthlink.h and return right away
+// done is called when the synth has answered or the command timed out
+// they return false if the link queue is full
+
 // read all 512 parameters from the FPGA
-void read_params(void) {
-  while (Serial2.available() == 1) Serial2.read(); // dump any unread shit
-  Serial2.write('d'); 
-  for (int i=0; i<512;++i) {
-    while (Serial2.available() == 0); // wait for the data
-    parameters[i]=Serial2.read();
-  }
+bool read_params(synthcallback done) {
+  return synth_queue(CMD_DUMP,0,0,parameters,done);
 }
 
 // load patch from FPGA memory
 // slot - FPGA memory slot number
-void loadpatch(uint8_t slot) {
-  Serial2.write('r'); 
-  Serial2.write(slot);
-  while (Serial2.available() == 0); // wait for the acknowledgement
-  Serial2.read(); // should be 0, I don't check
-  read_params(); 
+// a slot in the patch cache is copied into the parameter array right away and the synth only gets the 'r', no dump
+uint8_t loadingslot;  // slot of the load in progress
+uint8_t savingslot;   // slot of the save in progress
+bool savepending;     // the save is waiting for the edits ahead of it to go out
+synthcallback savedone;
+
+// scrolling thru slots in the Load Patch menu doesn't load every slot on the way
+// the slot number changes on screen right away but the load only starts when the encoder has been still for loadsettle ms
+#define LOAD_SETTLE 250
+uint16_t loadsettle=LOAD_SETTLE;
+bool loadpending;         // a slot change is waiting to settle
+uint32_t loadsissued;     // loads actually started
+uint32_t loadsskipped;    // slots scrolled past before their load started
+uint32_t loadscancelled;  // loads cancelled because a newer slot was picked
+
+bool loadpatch(uint8_t slot, synthcallback done) {
+  if (savepending) return false;  // the save needs the edits that are still waiting
+  writeq_clear();  // pending edits are for the patch we are replacing
+  loadingslot=slot;
+  if (cache_apply(slot)) return synth_queue(CMD_RECALL,slot,0,0,done);
+  return synth_queue(CMD_READ,slot,0,parameters,done);
+}
+
+// queue the pending save once the edits ahead of it have all gone - call every pass of loop()
+void deferredsave(void) {
+  if (!savepending || !writeq_flushall(1) || (synth_room() == 0)) return;
+  savepending=false;
+  synth_queue(CMD_WRITE,savingslot,0,0,savedone);
 }
 
 // write patch to FPGA memory
 // slot - FPGA memory slot number
-void writepatch(uint8_t slot) {
-  Serial2.write('w'); 
-  Serial2.write(slot);
-  while (Serial2.available() == 0); // wait for the acknowledgement
-  Serial2.read(); // should be 0, I don't check
+// the synth has to have all the edits before it saves. while the link is busy they wait in the link queue, so they go a
+// batch at a time as it has room and deferredsave() queues the write behind the last one
+// returns false if a save is already waiting
+bool writepatch(uint8_t slot, synthcallback done) {
+  if (savepending) return false;
+  savingslot=slot;
+  savedone=done;
+  savepending=true;
+  deferredsave();
+  return true;
 }
 
 // init patch
-void initpatch(void) {
-  Serial2.write('i'); 
-  while (Serial2.available() == 0); // wait for the acknowledgement
-  Serial2.read(); // should be 0, I don't check
-  read_params(); 
+bool initpatch(synthcallback done) {
+  if (savepending) return false;
+  writeq_clear();
+  return synth_queue(CMD_INIT,0,0,parameters,done);
 }
 
-// encoder timer 0 interrupt handler at 1khz
-// uses the millis timer
+// encoder timer interrupt handler at 1000000/ENC_TIMER_MICROS hz
+// the GPIO input registers are read once and all the encoders decode their pins from that snapshot
 void ICACHE_RAM_ATTR encTimer(){
-  menuEncoder.service();    // check the encoder inputs 
-  P1Encoder.service();
-  P2Encoder.service();
-  P3Encoder.service();
-  P4Encoder.service();
+  TRACE_ISR_BEGIN(TR_ENCTIMER);
+  uint64_t pins=ClickEncoder::readPins();
+  unsigned long now=millis();
+  for (uint8_t i=0; i< NUM_ENCODERS; ++i) encoders[i]->service(pins,now);  // check the encoder inputs
+  TRACE_ISR_END(TR_ENCTIMER);
 }
 
+// LCD timer interrupt handler - clocks one queued nibble out to the LCD
+void ICACHE_RAM_ATTR lcdTimer(){
+  lcdout.service();
+}
 
-// simple MIDI handler - 47Effects library crashes on me
-// called when there is MIDI data available
-// all we do here is detect incoming channel number and when the data arrived
-// this is used in maindisplay() to show the incoming MIDI channel
-
-void doMIDI(void) {
-  unsigned char mididata,midichannel;
-  mididata=Serial1.read();
-  if ((mididata & 0x90) == 0x90) {  // this is a note on message
-    //Serial.println(mididata);
-    incoming_MIDI_channel=(mididata &0x0f)+1;
-    midimessagetime=millis();
-  }
+// pot sampling timer interrupt handler - collects one A/D conversion and starts the next
+void ICACHE_RAM_ATTR potTimer(){
+  TRACE_ISR_BEGIN(TR_ADC);
+  pot_service();
+  TRACE_ISR_END(TR_ADC);
 }
 
+
 // menu stuff
 
 bool channeldisplay=false; // true while we are showing MIDI channel
-menu * topmenu=mainmenu;  // points at current menu
+const menu * topmenu=mainmenu;  // points at current menu
 int8_t topmenuindex;  // keeps track of which top menu item we are displaying
 int8_t mainmenuindex;  // saves index for main menu when we are in secondary menu
 int8_t secondarymenuindex;  // saves index for secondary menu when we are in main menu
@@ -204,101 +237,549 @@ bool message_displayed;
 
 // display the top menu
 void drawtopmenu( int8_t index) {
-    lcd.setCursor ( 0, TOPMENU_Y ); 
-    lcd.print("                    "); // kludgy line erase
-    lcd.setCursor ( 0, TOPMENU_Y ); 
-    lcd.print(topmenu[index].name);
+    lcdbuf.setCursor ( 0, TOPMENU_Y ); 
+    lcdbuf.print("                    "); // line erase - costs nothing, only changed characters go to the LCD
+    lcdbuf.setCursor ( 0, TOPMENU_Y ); 
+    lcdbuf.print(topmenu[index].name);
 }
 
 // display a sub menu item and its value
 // index is the index into the current top menu's submenu array
 // pos is the relative x location on the screen ie field 0,1,2 or 3 
 void drawsubmenu( int8_t index, int8_t pos) {
-    submenu * sub;
+    const submenu * sub;
+    TRACE_BEGIN(TR_DRAWSUBMENU);
     // print the name text
-    lcd.setCursor ((LCD_X/SUBMENU_FIELDS)*pos, SUBMENU_Y ); // set cursor to parameter name field
+    lcdbuf.setCursor ((LCD_X/SUBMENU_FIELDS)*pos, SUBMENU_Y ); // set cursor to parameter name field
     sub=topmenu[topmenuindex].submenus; //get pointer to the submenu array
-    if (index < topmenu[topmenuindex].numsubmenus) lcd.print(sub[index].name); // make sure we aren't beyond the last parameter in this submenu
-    else lcd.print("     ");
+    if (index < topmenu[topmenuindex].numsubmenus) lcdbuf.print(sub[index].name); // make sure we aren't beyond the last parameter in this submenu
+    else lcdbuf.print("     ");
 
     // print the value
-    lcd.setCursor ((LCD_X/SUBMENU_FIELDS)*pos, SUBMENU_VALUE_Y ); // set cursor to parameter value field
+    lcdbuf.setCursor ((LCD_X/SUBMENU_FIELDS)*pos, SUBMENU_VALUE_Y ); // set cursor to parameter value field
     if ((sub[index].parameter < DUMMY) && (index < topmenu[topmenuindex].numsubmenus)) { // don't print dummy parameter or beyond the last submenu item
       uint8_t val=parameters[sub[index].parameter];  // fetch the parameter value
-      if (val> sub[index].range) parameters[sub[index].parameter]=val=sub[index].range; // check the parameter range and limit if its out of range ie we loaded a bad patch
+      if (val> sub[index].range) val=sub[index].range; // out of range ie we loaded a bad patch or the synth set it - only show it limited so the editor still agrees with the synth
       switch (sub[index].ptype) {
         case TYPE_NUM:   // print the value as an unsigned integer    
           char temp[5];
           sprintf(temp,"%4u",val); // lcd.print doesn't seem to print uint8 properly
-          lcd.print(temp);  
-          lcd.print(" ");  // blank out any garbage
+          lcdbuf.print(temp);  
+          lcdbuf.print(pset_test(&edited,sub[index].parameter) ? "*" : " ");  // edited marker, or blank out any garbage
           break;
         case TYPE_TEXT:  // use the value to look up a string
-          lcd.print(sub[index].ptext[val]); // parameter value indexes into the string array
-          lcd.print(" ");  // blank out any garbage
+          lcdbuf.print(sub[index].ptext[val]); // parameter value indexes into the string array
+          lcdbuf.print(pset_test(&edited,sub[index].parameter) ? "*" : " ");
           break;
         default:
         case TYPE_NONE:  // blank out the field
-          lcd.print("     ");
+          lcdbuf.print("     ");
           break;
       } 
     }
-    else lcd.print("     ");  // it was a dummy parameter or an indexing error so blank the field 
+    else lcdbuf.print("     ");  // it was a dummy parameter or an indexing error so blank the field 
+    TRACE_END(TR_DRAWSUBMENU);
 }
 
 // display the sub menus of the current top menu
 
 void drawsubmenus() {
-  int8_t index = topmenu[topmenuindex].submenuindex;
+  int8_t index = submenuindex[topmenuindex];
   for (int8_t i=0; i< SUBMENU_FIELDS; ++i) drawsubmenu(index++,i);
 }
 
 //adjust the topmenu index and update the menus and submenus
 // dir - int value to add to the current top menu index ie L-R scroll
 void scrollmenus(int8_t dir) {
+  TRACE_BEGIN(TR_SCROLLMENUS);
   topmenuindex+= dir;
   if (topmenu== mainmenu) {
     if (topmenuindex < 0) topmenuindex = NUM_MAIN_MENUS -1; // handle wrap around
-    if (topmenuindex >= NUM_MAIN_MENUS ) topmenuindex = 0; // handle wrap around
+    if (topmenuindex >= (int8_t)NUM_MAIN_MENUS ) topmenuindex = 0; // handle wrap around
   }
   if (topmenu== secondarymenu) {
     if (topmenuindex < 0) topmenuindex = NUM_SECONDARY_MENUS -1; // handle wrap around
-    if (topmenuindex >= NUM_SECONDARY_MENUS ) topmenuindex = 0; // handle wrap around
+    if (topmenuindex >= (int8_t)NUM_SECONDARY_MENUS ) topmenuindex = 0; // handle wrap around
   }
   drawtopmenu(topmenuindex);
   drawsubmenus();    
+  TRACE_END(TR_SCROLLMENUS);
 }
 
 // same as above but scrolls submenus
 void scrollsubmenus(int8_t dir) {
   dir= dir*SUBMENU_FIELDS; // sidescroll SUBMENU_FIELDS at a time
-  topmenu[topmenuindex].submenuindex+= dir;
-  if (topmenu[topmenuindex].submenuindex < 0) topmenu[topmenuindex].submenuindex = 0; // stop at first submenu
-  if (topmenu[topmenuindex].submenuindex >= topmenu[topmenuindex].numsubmenus ) topmenu[topmenuindex].submenuindex -=dir; // stop at last submenu     
+  submenuindex[topmenuindex]+= dir;
+  if (submenuindex[topmenuindex] < 0) submenuindex[topmenuindex] = 0; // stop at first submenu
+  if (submenuindex[topmenuindex] >= topmenu[topmenuindex].numsubmenus ) submenuindex[topmenuindex] -=dir; // stop at last submenu     
   drawsubmenus();      
 }
 
 // show a message on 2nd line of display - it gets auto erased after a timeout
-void showmessage(char * message) {
-  lcd.setCursor(0, MSG_Y); 
-  lcd.print(message);
+void showmessage(const char * message) {
+  lcdbuf.setCursor(0, MSG_Y); 
+  lcdbuf.print("                    "); // erase what's left of the last message
+  lcdbuf.setCursor(0, MSG_Y); 
+  lcdbuf.print(message);
   messagetimer=millis();
   message_displayed=true;
 }
 
 // clear the message on the message line
 void erasemessage(void) {
-    lcd.setCursor(0, MSG_Y); 
-    lcd.print("                    "); 
+    lcdbuf.setCursor(0, MSG_Y); 
+    lcdbuf.print("                    "); 
     message_displayed=false;  
 }
 
-// unlock the volume pot
-void volumeunlock(void) {
-  volume_locked=false;  // unlock the volume so we use the pot volume, not the patch volume
-  volumetimer=millis();
+// simple MIDI handler - 47Effects library crashes on me
+// called every pass of loop(). everything waiting on the MIDI port goes thru the parser in midiparser.h, then we handle the events
+// all we do here is detect incoming channel number and when the data arrived
+// this is used in maindisplay() to show the incoming MIDI channel
+
+// handle the events parsed so far
+// page points at the first submenu on screen, fields is how many of the 4 fields are in use
+void midievents(const submenu * page, int8_t fields) {
+  struct midievent e;
+  while (midi_getevent(e)) {
+    switch (e.status) {
+      case MIDI_NOTEON:
+        if (e.data2 == 0) break;  // velocity 0 is really a note off
+        incoming_MIDI_channel=e.channel;
+        midimessagetime=millis();
+        break;
+      case MIDI_CC:
+        if (e.channel == MIDI_Channel) remote_cc(e.data1,e.data2,page,fields);
+        break;
+      case MIDI_SYSEX:
+        sysex_receive();  // patch dump requests and imports
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+// events are handled as each byte is parsed, so a burst of CCs or NRPNs waiting in the UART can't overflow the event queue
+void doMIDI(void) {
+  int8_t index=submenuindex[topmenuindex];  // the on screen parameters for CC FIELD_CC and up
+  const submenu * sub=topmenu[topmenuindex].submenus;
+  int8_t fields=topmenu[topmenuindex].numsubmenus-index;
+  while (Serial1.available()) {
+    bool sysex=midi_parse(Serial1.read());
+    midievents(&sub[index],fields);
+    if (sysex) break;  // one SysEx message a pass - an import can take a while
+  }
+  midi_rates();
 }
 
+// field of the LCD showing parameter p, -1 if it isn't on screen - a lookup in the reverse index, see menusystem.h
+int8_t paramfield(uint16_t p) {
+  if (p >= NUMPARAMS) return -1;
+  const struct paramplace & at=paramlocation(p);
+  int8_t m=(topmenu == mainmenu) ? topmenuindex : NUM_MAIN_MENUS+topmenuindex;
+  int8_t index=(at.menu == m) ? at.index : (at.menu2 == m) ? at.index2 : -1;
+  int8_t field=index-submenuindex[topmenuindex];
+  return ((index < 0) || (field < 0) || (field >= SUBMENU_FIELDS)) ? -1 : field;
+}
+
+// show parameters changed from MIDI
+// at most every REMOTE_DISPLAY_TIME ms so a fast CC stream doesn't keep the LCD busy, and only the field that changed is redrawn
+#define REMOTE_DISPLAY_TIME 100
+unsigned long remotedisplaytime;
+
+void remotedisplay(void) {
+  if ((millis() - remotedisplaytime) < REMOTE_DISPLAY_TIME) return;
+  if (remotelearned >= 0) {
+    char msg[LCD_X+1];
+    sprintf(msg,"CC %d Learned",remotelearned);
+    showmessage(msg);
+    remotelearned=-1;
+    drawsubmenus();  // learn switched itself off
+  }
+  if (!remotechanged) return;
+  remotechanged=false;
+  remotedisplaytime=millis();
+  int8_t field=paramfield(remoteparam);
+  if (field < 0) return;
+  int8_t index=submenuindex[topmenuindex]+field;
+  drawsubmenu(index,field);
+  showmessage(topmenu[topmenuindex].submenus[index].longname);
+}
+
+// parameter encoder button gestures
+// holding a parameter encoder button jumps to a top menu, rotating that encoder while the button is still down scrolls the top menus
+// each encoder has a small state machine stepped once per pass of loop() so nothing else waits while a button is held
+
+enum gesturestate {GESTURE_IDLE, GESTURE_HELD};
+
+struct gesture {
+  ClickEncoder * encoder;
+  int8_t jumpmenu;  // top menu we jump to when the button is held
+  uint8_t state;
+};
+
+struct gesture gestures[] = {
+  // encoder,jump to menu,state
+  &P1Encoder,OSCS,GESTURE_IDLE,
+  &P2Encoder,FILTERS,GESTURE_IDLE,
+  &P3Encoder,ENVELOPES,GESTURE_IDLE,
+  &P4Encoder,EFFECTS,GESTURE_IDLE,
+};
+
+// step the gesture state machine of parameter encoder n
+// returns the button event for the caller's click handling, Open while the encoder is busy with a held gesture
+ClickEncoder::Button dogesture(uint8_t n) {
+  struct gesture * g=&gestures[n];
+  ClickEncoder::Button button=g->encoder->getButton();
+  int16_t enc;
+  switch (g->state) {
+    case GESTURE_IDLE:
+      if (button != ClickEncoder::Held) return button;
+      topmenuindex=g->jumpmenu;
+      scrollmenus(0); // update the menus
+      erasemessage(); // screen cleanup
+      g->state=GESTURE_HELD;
+      break;
+    case GESTURE_HELD:
+      if (button != ClickEncoder::Held) {  // button was released
+        g->state=GESTURE_IDLE;
+        break;
+      }
+      enc=g->encoder->getValue();  // the parameter encoder scrolls top menus as long as the button is pressed
+      if (enc!=0) scrollmenus(enc);
+      break;
+  }
+  return ClickEncoder::Open;
+}
+
+// send the volume pot's setting to the synth - it replaces the volume of a newly loaded patch
+// does nothing if the pot hasn't been read yet, its first reading is sent when it comes in
+void volumefrompot(void) {
+  uint16_t position;
+  if (!pot_position(volumepot,&position)) return;
+  writeparameter(509,pot_scale(position,255),LC_POT); // adjust volume 0-255
+}
+
+#ifdef PARAMPOTS
+// turn a parameter pot's new position into an edit of the parameter in its field
+// a pot only takes over a parameter once it has been turned to the parameter's value - menu changes and encoder edits
+// leave the pot somewhere else and the parameter would jump to it otherwise. returns the change to apply
+int16_t potpickup(uint8_t field, const submenu * s, uint16_t position) {
+  static uint16_t potparam[4]={0xffff,0xffff,0xffff,0xffff};  // parameter each pot is on
+  static int16_t potlast[4];    // pot value at the previous event
+  static bool pickedup[4];
+  int16_t v=pot_scale(position,s->range);
+  int16_t current=parameters[s->parameter];
+  if ((potparam[field] != s->parameter) || (pickedup[field] && (current != potlast[field]))) {  // new parameter or edited elsewhere
+    potparam[field]=s->parameter;
+    pickedup[field]=false;
+    potlast[field]=v;
+  }
+  if (!pickedup[field]) {
+    pickedup[field]=(v == current) || ((potlast[field] < current) != (v < current));  // reached or crossed the value
+    potlast[field]=v;
+    if (!pickedup[field]) return 0;
+  }
+  potlast[field]=v;
+  return v-current;
+}
+#endif
+
+// link completion callbacks
+
+// the synth is back on the loaded slot after a prefetch or export read another one - the slot's volume came back with it
+void slotputback(uint8_t, uint8_t) {
+  volumefrompot();
+}
+
+// a patch load or init finished - the parameter array now holds the new patch
+// a failed read or init leaves the parameter array and its edits alone. a recall only fails after the cached image was copied
+// in, so that image becomes the base - either way the restore in paramsync.h puts the editor's patch on the synth when it answers
+void patchloaded(uint8_t cmd, uint8_t result) {
+  if (result != SYNTH_OK) {
+    loadedslot=-1;  // don't know what the synth has now
+    if (cmd == CMD_RECALL) {
+      edit_newbase(loadingslot);
+      drawsubmenus();
+    }
+    showmessage("Synth Not Responding");
+    return;
+  }
+  if (cmd == CMD_READ) cache_store(loadingslot,parameters);  // next time this slot loads from the cache
+  if (cmd == CMD_INIT) snap_setinit(parameters);  // snapshot base, if we didn't have it yet
+  loadedslot=(cmd == CMD_INIT) ? -1 : loadingslot;
+  edit_newbase((cmd == CMD_INIT) ? EDIT_INIT : loadingslot);
+  volumefrompot();   // use the volume from the volume pot
+  if (cmd == CMD_INIT) showmessage("Patch Initialized");
+  drawsubmenus();   // show the new values
+}
+
+// start the deferred patch load once the slot has settled - call every pass of loop()
+void deferredload(void) {
+  if (!loadpending || savepending || ((millis() - slotchangetime) < loadsettle)) return;
+  loadpending=false;
+  loadscancelled+=synth_cancel(patchloaded);  // an older load still queued or in flight is for a slot we have left behind
+  loadpatch(parameters[LOAD_SLOT],patchloaded);
+  ++loadsissued;
+}
+
+// a patch save finished
+void patchsaved(uint8_t, uint8_t result) {
+  if (result == SYNTH_OK) {
+    cache_store(savingslot,parameters);  // the slot now holds what we have in the editor
+    loadedslot=savingslot;
+    edit_newbase(savingslot);
+    drawsubmenus();   // clear the edited markers
+    showmessage("Patch Saved");
+  }
+  else {
+    cache_invalidate(savingslot);  // don't know what's in the slot now
+    showmessage("Save Failed-No Reply");
+  }
+}
+
+// show whether the selected snapshot is in use
+void snapshotbrowse(void) {
+  char msg[LCD_X+1];
+  uint16_t size=snap_size(parameters[SNAP_NUM]);
+  if (size == 0) showmessage("Empty");
+  else {
+    sprintf(msg,"Snapshot %u bytes",size);
+    showmessage(msg);
+  }
+}
+
+// the synth has the snapshot
+void snapshotloaded(uint8_t, uint8_t) {
+  volumefrompot();
+  showmessage("Snapshot Loaded");
+}
+
+void snapshotload(void) {
+  static uint8_t image[SYNTH_PARAMS];
+  if (savepending) {  // like loadpatch() - the save needs the patch and edits it was asked for
+    showmessage("Save In Progress");
+    return;
+  }
+  if (!snap_load(parameters[SNAP_NUM],image)) {
+    showmessage("No Snapshot");
+    return;
+  }
+  writeq_clear();  // edits still waiting belong to the patch being replaced
+  memcpy(parameters,image,SYNTH_PARAMS);
+  loadedslot=-1;   // not from a synth memory slot
+  edit_newbase(EDIT_NOBASE);
+  edit_snapshot(parameters[SNAP_NUM]);
+  synth_queue(CMD_UPLOAD,UPLOAD_ALL,0,parameters,snapshotloaded);
+  drawsubmenus();
+}
+
+// nothing is written if the snapshot already holds the patch - loaded or saved there and not edited since
+// otherwise the whole coded snapshot is written again. it only holds the bytes that differ from the init patch, but an
+// NVS blob can't be patched in place and keeping deltas against the previous snapshot would chain every load to it
+void snapshotsave(void) {
+  uint8_t n=parameters[SNAP_NUM];
+  if ((snapclean == n) && pset_empty(&snapedited)) showmessage("Snapshot Unchanged");
+  else if (snap_save(n,parameters)) {
+    edit_snapshot(n);
+    showmessage("Snapshot Saved");
+  }
+  else showmessage("Snapshot Failed");
+}
+
+#ifdef CODEC_BENCHMARK
+// read the first few memory slots into the patch cache and benchmark the patch codec on them
+#define CODEC_CORPUS 32
+void codecbenchmark(void) {
+  for (uint8_t slot=0; slot < CODEC_CORPUS; ++slot) {
+    prefetchslot=slot;
+    synth_queue(CMD_READ,slot,0,cachefill,cache_prefetched);
+    synth_wait();
+  }
+  synth_queue(CMD_UPLOAD,UPLOAD_ALL,0,parameters,NULL);  // reading the slots replaced the synth's patch
+  synth_wait();
+  if (initknown) codec_benchmark(initimage,"init patch");
+  codec_benchmark(snap_base(SNAP_BASEZERO),"zeros");
+}
+#endif
+
+#ifdef SDCARD
+// library entry selected by the LIB_BANK and LIB_NUM fields
+uint16_t librarynumber(void) {
+  return parameters[LIB_BANK]*LIB_PERBANK+parameters[LIB_NUM];
+}
+
+// show the name of the selected library patch
+void librarybrowse(void) {
+  if (!libready) showmessage("No SD Card");
+  else if (lib_browse(librarynumber())) showmessage(libcurrent.name);
+  else showmessage("Empty");
+}
+
+// the synth has the library patch
+void libraryloaded(uint8_t, uint8_t) {
+  volumefrompot();
+  showmessage("Library Patch Loaded");
+}
+
+void libraryload(void) {
+  static uint8_t image[SYNTH_PARAMS];
+  if (savepending) {  // like loadpatch() - the save needs the patch and edits it was asked for
+    showmessage("Save In Progress");
+    return;
+  }
+  if (!lib_load(librarynumber(),image)) {
+    if (libready) showmessage("Load Failed");
+    else showmessage("No SD Card");
+    return;
+  }
+  writeq_clear();  // edits still waiting belong to the patch being replaced
+  memcpy(parameters,image,SYNTH_PARAMS);
+  loadedslot=-1;   // not from a synth memory slot
+  edit_newbase(EDIT_NOBASE);
+  synth_queue(CMD_UPLOAD,UPLOAD_ALL,0,parameters,libraryloaded);
+  drawsubmenus();
+}
+
+void librarysave(void) {
+  char name[LIB_NAMELEN];
+  if (loadedslot >= 0) sprintf(name,"XVA1 Slot %d",loadedslot);
+  else strcpy(name,"Edited Patch");
+  if (lib_save(librarynumber(),parameters,name)) showmessage("Saved to Library");
+  else if (libready) showmessage("Save Failed");
+  else showmessage("No SD Card");
+}
+#endif
+
+// menu position and internal parameters kept with the boot state
+const uint16_t bootparams[]={LOAD_SLOT,WRITE_SLOT,SNAP_NUM,LIB_BANK,LIB_NUM};
+#define BOOT_PARAMS (sizeof(bootparams)/sizeof(bootparams[0]))
+#define MENUSTATE_LEN (4+NUM_MAIN_MENUS+NUM_SECONDARY_MENUS+BOOT_PARAMS)
+uint8_t menustate[BOOT_MENUBYTES];
+unsigned long firstframetime;  // millis() at power on to the first frame on the LCD
+
+uint8_t packmenu(uint8_t * m) {
+  uint8_t n=0;
+  m[n++]=(topmenu == secondarymenu);
+  m[n++]=topmenuindex;
+  m[n++]=mainmenuindex;
+  m[n++]=secondarymenuindex;
+  for (uint8_t i=0; i < NUM_MAIN_MENUS; ++i) m[n++]=mainsubmenuindex[i];
+  for (uint8_t i=0; i < NUM_SECONDARY_MENUS; ++i) m[n++]=secondarysubmenuindex[i];
+  for (uint8_t i=0; i < BOOT_PARAMS; ++i) m[n++]=parameters[bootparams[i]];
+  return n;
+}
+
+// restore the menu position - returns false if it doesn't fit the menus in this build
+bool unpackmenu(const uint8_t * m, uint8_t len) {
+  uint8_t n=4;
+  if ((len != MENUSTATE_LEN) || (m[1] >= (m[0] ? NUM_SECONDARY_MENUS : NUM_MAIN_MENUS)) || (m[2] >= NUM_MAIN_MENUS)
+      || (m[3] >= NUM_SECONDARY_MENUS)) return false;
+  for (uint8_t i=0; i < NUM_MAIN_MENUS; ++i) if ((int8_t)m[n++] >= mainmenu[i].numsubmenus) return false;
+  for (uint8_t i=0; i < NUM_SECONDARY_MENUS; ++i) if ((int8_t)m[n++] >= secondarymenu[i].numsubmenus) return false;
+  n=4;
+  topmenu=m[0] ? secondarymenu : mainmenu;
+  submenuindex=m[0] ? secondarysubmenuindex : mainsubmenuindex;
+  mainmenuindex=m[2];
+  secondarymenuindex=m[3];
+  topmenuindex=m[1];
+  for (uint8_t i=0; i < NUM_MAIN_MENUS; ++i) mainsubmenuindex[i]=m[n++];
+  for (uint8_t i=0; i < NUM_SECONDARY_MENUS; ++i) secondarysubmenuindex[i]=m[n++];
+  for (uint8_t i=0; i < BOOT_PARAMS; ++i) parameters[bootparams[i]]=m[n++];
+  return true;
+}
+
+// the background dump at boot finished - fix whatever the saved state got wrong
+void bootresynced(uint8_t, uint8_t result) {
+  if (result != SYNTH_OK) {
+    showmessage("Synth Not Responding");
+    return;
+  }
+  if (boot_correct()) drawsubmenus();  // the frame buffer only sends the fields that changed
+#ifdef DEBUG
+  Serial.printf("resync at %lu ms, %u parameters corrected\n",millis(),bootcorrected);
+#endif
+}
+
+// the editor's patch is back on the synth after the link failed
+void restored(uint8_t, uint8_t) {
+  volumefrompot();
+  showmessage("Synth Reconnected");
+}
+
+// a background sync dump finished - redraw the on screen fields whose parameters were changed on the synth
+void synced(uint8_t, uint8_t result) {
+  bool reconnected=sync_finished(result);
+  if (result != SYNTH_OK) return;
+  if (reconnected && sync_restore(restored)) return;  // the synth may have been reset - don't take its parameters, give it ours
+  if (sync_correct() == 0) return;
+  for (uint16_t p=pset_next(&syncchanged,0); p < PSET_PARAMS; p=pset_next(&syncchanged,p+1)) {
+    int8_t field=paramfield(p);
+    if (field >= 0) drawsubmenu(submenuindex[topmenuindex]+field,field);
+  }
+}
+
+// report the end of a SysEx transfer
+void sysexdone(uint8_t result) {
+  switch (result) {
+    case SX_EXPORTED:
+      showmessage("SysEx Sent");
+      break;
+    case SX_IMPORTED:
+      if (!sxedit) parameters[LOAD_SLOT]=sxslot;
+      volumefrompot();
+      drawsubmenus();  // show the imported patch
+      showmessage("SysEx Received");
+      break;
+    case SX_FAILED:
+      showmessage("SysEx Failed");
+      break;
+    case SX_REFUSED:
+      showmessage("Save Patch First");  // can't read slots for the host without losing the edits
+      break;
+    case SX_SAVING:
+      showmessage("Save In Progress");  // an import can't replace the patch a save is waiting for
+      break;
+  }
+}
+
+#ifdef DEBUG
+// debug serial commands - a line at a time, anything we don't know is ignored
+// the serial RX pin is shared with an encoder switch so a stray byte now and then is expected
+// trace - dump the trace rings, see trace.h
+// link - link scheduler and write queue counters, see linksched.h and writequeue.h
+// stats - LCD traffic, encoder event ring, MIDI input and patch browsing counters, see lcdbuffer.h, ClickEncoder.h
+// and midiparser.h
+#define DEBUG_CMD_LEN 16
+char debugcmd[DEBUG_CMD_LEN+1];
+uint8_t debugcmdlen;
+
+void debugcommands(void) {
+  while (Serial.available()) {
+    char c=Serial.read();
+    if ((c != '\n') && (c != '\r')) {
+      if (debugcmdlen < DEBUG_CMD_LEN) debugcmd[debugcmdlen++]=c;
+      continue;
+    }
+    debugcmd[debugcmdlen]=0;
+    debugcmdlen=0;
+    if (!strcmp(debugcmd,"trace")) trace_dump(Serial);
+    if (!strcmp(debugcmd,"link")) {
+      sched_report(Serial);
+      writeq_report(Serial);
+    }
+    if (!strcmp(debugcmd,"stats")) {
+      Serial.printf("lcd frames %u, last frame %u bytes, total %u bytes\n",lcdbuf.frames,lcdbuf.framebytes,lcdbuf.totalbytes);
+      for (uint8_t i=0; i < NUM_ENCODERS; ++i) {
+        Serial.printf("encoder %u events lost %u, most waiting %u\n",i,encoders[i]->getOverflows(),encoders[i]->getHighWater());
+      }
+      Serial.printf("midi %u bytes/s, %u events/s, events lost %u\n",midibyterate,midimsgrate,midioverflows);
+      Serial.printf("patch loads %u, skipped %u, cancelled %u\n",loadsissued,loadsskipped,loadscancelled);
+    }
+  }
+}
+#endif
 
 void setup() {
   
@@ -319,18 +800,46 @@ void setup() {
   channeldisplay=false; // true while we are showing MIDI channel
   Serial1.begin(31250, SERIAL_8N1, MIDIRX, MIDITX);
 
-  read_params(); // sync the parameter array to the synth
+  cache_init();
+  slotrestored=slotputback;
+
+  // pots are sampled in the background from here on - the 1st timer starts the A/D conversions
+  volumepot=pot_attach(VOLUMEPOT);
+#ifdef PARAMPOTS
+  for (uint8_t i=0; i < 4; ++i) parampots[i]=pot_attach(parampotpins[i]);
+#endif
+  timer0 = timerBegin(0, 80, true);
+  timerAttachInterrupt(timer0, &potTimer, true);
+  timerAlarmWrite(timer0, POT_TIMER_MICROS, true);
+  timerAlarmEnable(timer0);
+  snap_begin();      // NVS - snapshots and the boot state
+  uint8_t menulen=boot_restore(menustate);  // last parameters and menu position, if we have them
+  if (menulen) unpackmenu(menustate,menulen);
   
      // start up the display - 20 chars by 4 lines
   lcd.begin(LCD_X,LCD_Y);               // initialize the lcd 
-  lcd.home ();                   // go home
-  lcd.print("       XVA1");
-  delay (1000);
-  topmenuindex=0;
-  mainmenuindex=0;
-  secondarymenuindex=0;
+
+  // 3rd timer clocks characters out to the LCD in the background
+  timer2 = timerBegin(2, 80, true);
+  timerAttachInterrupt(timer2, &lcdTimer, true);
+  timerAlarmWrite(timer2, LCD_TIMER_MICROS, true);
+  timerAlarmEnable(timer2);
+
+  // draw the restored state right away - the synth is checked in the background
   drawtopmenu(topmenuindex);    // initial menu display
   drawsubmenus();
+  showmessage("       XVA1");    // splash goes away on the message timeout
+  lcdbuf.update();
+  lcdout.wait();
+  firstframetime=millis();
+
+  boot_resync(bootresynced);  // dump the synth's parameters, bootresynced() fixes the ones that differ
+#ifdef SDCARD
+  lib_begin();       // finishes any library save cut off by a power failure
+#endif
+#ifdef CODEC_BENCHMARK
+  codecbenchmark();
+#endif
 
 
   // 2nd timer for encoder sampling
@@ -340,10 +849,22 @@ void setup() {
   // Repeat the alarm (third parameter)
   timerAlarmWrite(timer1, ENC_TIMER_MICROS, true);
   timerAlarmEnable(timer1);
+#if ENC_EDGE_INTERRUPTS
+  for (uint8_t i=0; i< NUM_ENCODERS; ++i) encoders[i]->attachEdgeInterrupts(); // A/B decoding moves to pin change interrupts
+#endif
+#ifdef DEBUG
+  Serial.printf("first frame at %lu ms, usable at %lu ms, state %s\n",firstframetime,millis(),menulen ? "restored" : "not saved");
+#endif
 }
 
 
+// loop() timing - nothing in loop() waits for the synth, the LCD or a button so the worst case should stay small
+unsigned long looptime;  // us taken by the last pass
+unsigned long loopmax;   // worst case us since startup
+
 void loop() {
+  unsigned long loopstart=micros();
+  TRACE_BEGIN(TR_LOOP);
   int16_t enc;
   int8_t index; 
   int16_t encodervalue[4]; 
@@ -351,7 +872,20 @@ void loop() {
   ClickEncoder::Button button; 
   
 //  MIDI.read();  // do serial MIDI
-  if (Serial1.available()) doMIDI();
+  TRACE_BEGIN(TR_MIDI);
+  doMIDI();
+  TRACE_END(TR_MIDI);
+
+  TRACE_BEGIN(TR_LINK);
+  synth_poll();  // move any synth command along
+  TRACE_END(TR_LINK);
+
+  // take everything the encoder ISR has queued since the last pass in one batch
+  // rotation and clicks wait in each encoder until getValue()/getButton() below so nothing gets lost while loop() is busy
+  for (uint8_t i=0; i< NUM_ENCODERS; ++i) encoders[i]->drain();
+  TRACE_BEGIN(TR_WRITEQ);
+  writeq_flush(); // send queued parameter writes
+  TRACE_END(TR_WRITEQ);
 
 // process the menu encoder - scroll submenus, scroll main menu when button down
   enc=menuEncoder.getValue(); // compiler bug - can't do this inside the if statement
@@ -378,12 +912,14 @@ void loop() {
    // toggle main and secondary
      if (topmenu==mainmenu) {
        topmenu=secondarymenu;
+       submenuindex=secondarysubmenuindex;
        mainmenuindex=topmenuindex; // save where we are
        topmenuindex=secondarymenuindex; // restore secondary menu position
        showmessage("* 2nd Menu Active");
      }
      else {
        topmenu=mainmenu;
+       submenuindex=mainsubmenuindex;
        secondarymenuindex=topmenuindex; // save where we are
        topmenuindex=mainmenuindex;  // restore main menu position
        showmessage("Main Menu Active");
@@ -392,138 +928,156 @@ void loop() {
   }
  
 // process parameter encoder buttons - button gestures are used as shortcuts/alternatives to using main encoder
-// hold button to jump to specific top menus, then can rotate to scroll top menus 
+// hold button to jump to specific top menus, then can rotate to scroll top menus - see dogesture()
 // middle left encoder click goes to previous menu
 // middle right encoder click goes to next menu
 // left encoder click goes to previous submenu
 // right encoder click goes to next submenu
-  index= topmenu[topmenuindex].submenuindex; // submenu field index
-  submenu * sub=topmenu[topmenuindex].submenus; //get pointer to the current submenu array
-  button= P1Encoder.getButton();
-  
-  switch (button) {
-    case ClickEncoder::Held:
-      topmenuindex=OSCS;
-      scrollmenus(0); // update the menus 
-      erasemessage(); // screen cleanup
-      while (P1Encoder.getButton() == ClickEncoder::Held) {  // the parameter encoder to scrolls top menus as long as the button is pressed
-        enc=P1Encoder.getValue();
-        if (enc!=0) scrollmenus(enc); 
-      }  
-      break;  
-    case ClickEncoder::Clicked:
-      scrollsubmenus(-1);    // click on left encoder goes to previous submenu
-      break;
-    case ClickEncoder::DoubleClicked:
-      switch (sub[index].parameter) {  // these menus use internal parameters
-        case INIT_SLOT:
-          initpatch();
-          volumeunlock();   // use the volume from the volume pot
-          showmessage("Patch Initialized");
-          break;
-        case WRITE_SLOT:
-          writepatch(parameters[WRITE_SLOT]);
-          showmessage("Patch Saved");
-          break;
-        default:
-        break;
-      }
-  }
+  index= submenuindex[topmenuindex]; // submenu field index
+  const submenu * sub=topmenu[topmenuindex].submenus; //get pointer to the current submenu array
 
-  button= P2Encoder.getButton();
-  switch (button) {
-    case ClickEncoder::Held:
-      topmenuindex=FILTERS;
-      scrollmenus(0); // update the menus 
-      erasemessage(); // screen cleanup
-      while (P2Encoder.getButton() == ClickEncoder::Held) {  // the parameter encoder to scrolls top menus as long as the button is pressed
-        enc=P2Encoder.getValue();
-        if (enc!=0) scrollmenus(enc); 
-      }  
-      break;  
-    case ClickEncoder::Clicked:
-      scrollmenus(-1);    // click on middle left encoder goes to previous menu
-      break;
-  }
-  
-  button= P3Encoder.getButton();
-  switch (button) {
-    case ClickEncoder::Held:
-      topmenuindex=ENVELOPES;
-      scrollmenus(0); // update the menus 
-      erasemessage(); // screen cleanup
-      while (P3Encoder.getButton() == ClickEncoder::Held) {  // the parameter encoder to scrolls top menus as long as the button is pressed
-        enc=P3Encoder.getValue();
-        if (enc!=0) scrollmenus(enc); 
-      }  
-      break;  
-    case ClickEncoder::Clicked:
-      scrollmenus(1);    // click ond middle right encoder goes to next menu
-      break;
+  for (uint8_t field=0; field < 4; ++field) {
+    button= dogesture(field);
+    switch (field) {
+      case 0:
+        if (button == ClickEncoder::Clicked) scrollsubmenus(-1);    // click on left encoder goes to previous submenu
+        if (button == ClickEncoder::DoubleClicked) {
+          switch (sub[index].parameter) {  // these menus use internal parameters
+            case INIT_SLOT:
+              if (!initpatch(patchloaded)) showmessage("Synth Busy-Try Again");  // patchloaded() reports when its done
+              break;
+            case WRITE_SLOT:
+              if (!writepatch(parameters[WRITE_SLOT],patchsaved)) showmessage("Save In Progress");
+              break;
+            default:
+            break;
+          }
+        }
+        break;
+      case 1:
+        if (button == ClickEncoder::Clicked) scrollmenus(-1);    // click on middle left encoder goes to previous menu
+        break;
+      case 2:
+        if (button == ClickEncoder::Clicked) scrollmenus(1);    // click on middle right encoder goes to next menu
+        if (button == ClickEncoder::DoubleClicked) {
+          switch (sub[index+2].parameter) {  // load from snapshot or library
+            case SNAP_LOAD:
+              snapshotload();
+              break;
+#ifdef SDCARD
+            case LIB_LOAD:
+              libraryload();
+              break;
+#endif
+            default:
+            break;
+          }
+        }
+        break;
+      case 3:
+        if (button == ClickEncoder::Clicked) scrollsubmenus(1);    // click on right encoder goes to next submenu
+        if (button == ClickEncoder::DoubleClicked) {
+          switch (sub[index+3].parameter) {  // save to snapshot or library
+            case SNAP_SAVE:
+              snapshotsave();
+              break;
+#ifdef SDCARD
+            case LIB_SAVE:
+              librarysave();
+              break;
+#endif
+            default:
+            break;
+          }
+        }
+        break;
+    }
   }
+  index= submenuindex[topmenuindex]; // a click or gesture may have moved us
+  sub=topmenu[topmenuindex].submenus;
 
-  button= P4Encoder.getButton();
-  switch (button) {
-    case ClickEncoder::Held:
-      topmenuindex=EFFECTS;
-      scrollmenus(0); // update the menus 
-      erasemessage(); // screen cleanup
-      while (P4Encoder.getButton() == ClickEncoder::Held) {  // the parameter encoder to scrolls top menus as long as the button is pressed
-        enc=P4Encoder.getValue();
-        if (enc!=0) scrollmenus(enc); 
-      }  
-      break;  
-    case ClickEncoder::Clicked:
-      scrollsubmenus(1);    // click on right encoder goes to next submenu
-      break;
+ // pots that moved since the last pass - the volume pot goes straight to the synth
+  struct potevent potev;
+#ifdef PARAMPOTS
+  int16_t potposition[4]={-1,-1,-1,-1};  // new position of each parameter pot, -1 if it didn't move
+#endif
+  while (pot_event(potev)) {
+    if (potev.channel == volumepot) writeparameter(509,pot_scale(potev.position,255),LC_POT); // adjust volume 0-255
+#ifdef PARAMPOTS
+    for (uint8_t i=0; i < 4; ++i) {
+      if (potev.channel == parampots[i]) potposition[i]=potev.position;
+    }
+#endif
   }
 
  // process parameter encoders
-  encodervalue[0]=P1Encoder.getValue();  // read encoders
-  encodervalue[1]=P2Encoder.getValue();
-  encodervalue[2]=P3Encoder.getValue();
-  encodervalue[3]=P4Encoder.getValue();
+  for (int field=0; field<4;++field) {  // read encoders - one that is scrolling menus for a held gesture doesn't edit
+    encodervalue[field]=(gestures[field].state == GESTURE_HELD) ? 0 : gestures[field].encoder->getValue();
+  }
 
   for (int field=0; field<4;++field) { // loop thru the on screen submenus
+#ifdef PARAMPOTS
+    if (potposition[field] >= 0) encodervalue[field]+=potpickup(field,&sub[index],potposition[field]);
+#endif
     if (encodervalue[field]!=0) {  // if there is some input, process it
       uint16_t p=sub[index].parameter; // array index of the parameter we are editing
       int16_t temp=(int16_t)parameters[p] + encodervalue[field]; // use ints here - way easier to handle overflows
       if (temp < 0) temp=0;
       if (temp > (int16_t)sub[index].range) temp=sub[index].range;
       parameters[p]=(uint8_t)temp;
-      if (p < LOAD_SLOT) setparameter(p); // don't send internal parameters to the FPGA
-      if (p == LOAD_SLOT) {
-        loadpatch(parameters[p]); // load patch happens when we change the patch number in that submenu
-        volumeunlock();   // use the volume from the volume pot
+      if (p < LOAD_SLOT) {  // don't send internal parameters to the FPGA
+        setparameter(p);
+        lastedited=p;       // MIDI CC learn binds to this one
+        lasteditedrange=sub[index].range;
+      }
+      if (p == LOAD_SLOT) {   // load patch happens when we change the patch number in that submenu - see deferredload()
+        slotchangetime=millis();  // also holds off prefetching while the slot is changing
+        if (loadpending) ++loadsskipped;
+        loadpending=true;
       }
       showmessage(sub[index].longname);  // show the long name of what we are editing
+      if (p == SNAP_NUM) snapshotbrowse();
+#ifdef SDCARD
+      if ((p == LIB_BANK) || (p == LIB_NUM)) librarybrowse();  // shows the patch name instead
+#endif
       drawsubmenu(index,field);
     }
     ++index;
     if (index >= topmenu[topmenuindex].numsubmenus) break; // check that we have not run out of submenus
   }
 
-// handle volume which has a dedicated pot
-// we lock the volume after a while because the A/D jumps around and causes audio crackles
-  int16_t cv_in=0;
-  for (int i=0; i< CV_AVG; ++i) cv_in+=analogRead(VOLUMEPOT); // average the noisy A/D 
-  cv_in=(cv_in/CV_AVG)/CV_SCALE;
-  int delta = abs(cv_in-volume);
-  if (delta > VOLUME_THRESHOLD) {
-    volume_locked=false; // we hit the threshold, unlock the pot and reset the timer
-    volumetimer=millis();  
-  }
-
-  if (volume_locked == false) {
-    volume=cv_in;
-    writeparameter(509,(unsigned char)(volume)); // adjust volume 0-255
-  }
-
 // timer housekeeping
-  if ((millis() - volumetimer) > VOLUME_LOCK) volume_locked=true; 
-  
   if (((millis() - messagetimer) > MESSAGE_TIMEOUT) && (message_displayed==true)) erasemessage();
 
+  remotedisplay();  // follow parameters changed from MIDI
+
+  deferredsave();   // save once the edits ahead of it have gone
+  deferredload();   // load the selected patch once the slot encoder settles
+
+  sysexdone(sysex_poll());  // stream SysEx transfers
+
+  // fill the patch cache around the selected slot while the Load Patch menu is up
+  sub=topmenu[topmenuindex].submenus;
+  bool quiet=(millis() - midimessagetime) > PREFETCH_QUIET;  // reading a slot would switch the sound under the notes
+  if (!sysex_busy()) cache_prefetch(parameters[LOAD_SLOT],quiet && (sub[submenuindex[topmenuindex]].parameter == LOAD_SLOT));
+
+  // follow changes made on the synth while nothing else is using the link
+  if (!loadpending && !sysex_busy() && sync_due()) sync_start(synced);
+
+  if (boot_due()) boot_check(menustate,packmenu(menustate));  // save the state for the next boot once it settles
+
+  TRACE_BEGIN(TR_LCDUPDATE);
+  lcdbuf.update();  // send whatever changed on the display this pass
+  TRACE_END(TR_LCDUPDATE);
+
+#ifdef DEBUG
+  debugcommands();
+#endif
+
+  TRACE_END(TR_LOOP);
+  looptime=micros()-loopstart;
+  if (looptime > loopmax) loopmax=looptime;
+
 
 }
 